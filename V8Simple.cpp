@@ -1,10 +1,91 @@
 #include "V8Simple.h"
 #include <include/v8.h>
 #include <include/v8-debug.h>
+#include <include/v8-profiler.h>
 #include <include/libplatform/libplatform.h>
+#include <include/libplatform/v8-tracing.h>
 #include <vector>
 #include <cstdlib>
+#include <cstring>
+#include <climits>
 #include <atomic>
+#include <new>
+#include <type_traits>
+#include <mutex>
+#include <unordered_map>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <cstdio>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#include <fstream>
+
+// -------------------------------------------------------------------------
+// Instrumentation
+// Built in with V8SIMPLE_INSTRUMENTATION (make INSTRUMENTATION=1). Without
+// it the checks below are constant false and compile away.
+#ifdef V8SIMPLE_INSTRUMENTATION
+static const bool InstrumentationBuilt = true;
+#else
+static const bool InstrumentationBuilt = false;
+#endif
+
+struct CallCounter
+{
+	std::atomic<int64_t> Calls;
+	std::atomic<int64_t> Nanoseconds;
+};
+
+static const int InstrumentedCallCount = static_cast<int>(JSInstrumentedCall::Count);
+static CallCounter _callCounters[InstrumentedCallCount];
+static std::atomic<bool> _instrumentationEnabled(false);
+static std::atomic<int64_t> _wrapperAllocations(0);
+static std::atomic<int64_t> _liveObjects(0);
+// Flag for the library's trace event category while StartJSTracing is in
+// effect, owned by the tracing controller
+static std::atomic<const uint8_t*> _traceCategory(nullptr);
+
+static inline bool InstrumentationEnabled()
+{
+	return InstrumentationBuilt && _instrumentationEnabled.load(std::memory_order_relaxed);
+}
+
+static inline bool TraceEnabled()
+{
+	if (!InstrumentationBuilt)
+		return false;
+	auto category = _traceCategory.load(std::memory_order_relaxed);
+	return category != nullptr && *category != 0;
+}
+
+// Counts calls that are too short to be worth timing
+static inline void CountCall(JSInstrumentedCall call)
+{
+	if (InstrumentationEnabled())
+		_callCounters[static_cast<int>(call)].Calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Counts and times the entry point or callback it's scoped to, and emits a
+// complete trace event for it while the v8simple category is traced.
+struct InstrumentedCall
+{
+	const JSInstrumentedCall Call;
+	const char* const Name;
+	const bool Timed;
+	const uint8_t* TraceCategory;
+	uint64_t TraceHandle;
+	std::chrono::steady_clock::time_point Start;
+
+	InstrumentedCall(JSInstrumentedCall call, const char* name);
+	~InstrumentedCall();
+};
 
 struct RefCounted
 {
@@ -13,6 +94,8 @@ struct RefCounted
 	RefCounted()
 	{
 		_refCount = 1;
+		if (InstrumentationBuilt)
+			_liveObjects.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	void Retain()
@@ -20,6 +103,18 @@ struct RefCounted
 		++_refCount;
 	}
 
+	// Retains unless the object is already being destroyed
+	bool TryRetain()
+	{
+		auto refCount = _refCount.load();
+		while (refCount > 0)
+		{
+			if (_refCount.compare_exchange_weak(refCount, refCount + 1))
+				return true;
+		}
+		return false;
+	}
+
 	void Release()
 	{
 		auto newRefCount = --_refCount;
@@ -29,461 +124,2553 @@ struct RefCounted
 		}
 	}
 
-	virtual ~RefCounted() { }
+	// Releases unless this is the last reference, which is left to the
+	// caller
+	bool ReleaseUnlessLast()
+	{
+		auto refCount = _refCount.load();
+		while (refCount > 1)
+		{
+			if (_refCount.compare_exchange_weak(refCount, refCount - 1))
+				return true;
+		}
+		return false;
+	}
+
+	virtual ~RefCounted()
+	{
+		if (InstrumentationBuilt)
+			_liveObjects.fetch_sub(1, std::memory_order_relaxed);
+	}
 };
 
-struct ArrayBufferAllocator: v8::ArrayBuffer::Allocator
+// Reference counted so that serialized values can keep the allocator of
+// the array buffers they've taken over alive
+struct ArrayBufferAllocator: v8::ArrayBuffer::Allocator, RefCounted
 {
+	const JSArrayBufferAllocatorKind Kind;
+	std::atomic<int64_t> AllocationCount;
+	std::atomic<int64_t> FreeCount;
+	std::atomic<int64_t> AllocatedBytes;
+	std::atomic<int64_t> PoolHitCount;
+	std::atomic<int64_t> PooledBytes;
+	std::atomic<int64_t> LargeAllocationCount;
+
+	ArrayBufferAllocator(JSArrayBufferAllocatorKind kind = JSArrayBufferAllocatorKind::Default)
+		: Kind(kind)
+	{
+		AllocationCount = 0;
+		FreeCount = 0;
+		AllocatedBytes = 0;
+		PoolHitCount = 0;
+		PooledBytes = 0;
+		LargeAllocationCount = 0;
+	}
+
 	virtual void* Allocate(size_t length)
 	{
-		return calloc(length, 1);
+		return Allocated(calloc(length, 1), length);
 	}
 
 	virtual void* AllocateUninitialized(size_t length)
 	{
-		return malloc(length);
+		return Allocated(malloc(length), length);
 	}
 
-	virtual void Free(void* data, size_t)
+	virtual void Free(void* data, size_t length)
 	{
+		Freed(data, length);
 		free(data);
 	}
-};
-
-v8::Platform* _platform = nullptr;
 
-// Using this and not plain v8::Persistents ensures that the references are
-// reset in the destructor.
-template<class T>
-using ResettingPersistent = v8::Persistent<T, v8::CopyablePersistentTraits<T>>;
+	// Returns cached memory to the system
+	virtual void Trim() { }
 
-struct JSContext : RefCounted
-{
-	const JSCallbackFinalizer CallbackFinalizer;
-	const JSExternalFinalizer ExternalFinalizer;
-	v8::Isolate* Isolate;
-	ResettingPersistent<v8::Context> Handle;
-	JSDebugMessageHandler DebugMessageHandler;
-	void* DebugMessageHandlerData;
+	// Whether this allocator can free memory allocated by other
+	virtual bool CanFree(const ArrayBufferAllocator* other) const
+	{
+		return other->Kind == JSArrayBufferAllocatorKind::Default;
+	}
 
-	JSContext(
-		JSCallbackFinalizer callbackFinalizer,
-		JSExternalFinalizer externalFinalizer)
-		: CallbackFinalizer(callbackFinalizer)
-		, ExternalFinalizer(externalFinalizer)
-		, DebugMessageHandler(nullptr)
-		, DebugMessageHandlerData(nullptr)
+	void* Allocated(void* data, size_t length)
 	{
-		if (_platform == nullptr)
+		if (data != nullptr)
 		{
-			v8::V8::InitializeICU();
-			_platform = v8::platform::CreateDefaultPlatform();
-			v8::V8::InitializePlatform(_platform);
-			v8::V8::Initialize();
+			++AllocationCount;
+			AllocatedBytes += static_cast<int64_t>(length);
 		}
+		return data;
+	}
 
-		static ArrayBufferAllocator arrayBufferAllocator;
-		v8::Isolate::CreateParams createParams;
-		createParams.array_buffer_allocator = &arrayBufferAllocator;
-		Isolate = v8::Isolate::New(createParams);
+	void Freed(void* data, size_t length)
+	{
+		if (data != nullptr)
+		{
+			++FreeCount;
+			AllocatedBytes -= static_cast<int64_t>(length);
+		}
+	}
+};
 
-		v8::Locker locker(Isolate);
-		v8::Isolate::Scope isolateScope(Isolate);
-		v8::HandleScope handleScope(Isolate);
+// Keeps freed small buffers in power of two size classes for reuse by the
+// same isolate, and maps large buffers directly from the OS so that they
+// don't fragment the heap.
+struct PooledArrayBufferAllocator: ArrayBufferAllocator
+{
+	static const size_t MinClassSize = 16;
+	static const int ClassCount = 13; // Up to 64 KB
 
-		auto localContext = v8::Context::New(Isolate);
-		v8::Context::Scope contextScope(localContext);
+	std::mutex Mutex;
+	std::vector<void*> Pools[ClassCount];
+	size_t MaxPooledBytes;
+	size_t LargeBufferSize;
 
-		Handle.Reset(Isolate, localContext);
+	PooledArrayBufferAllocator(size_t maxPooledBytes, size_t largeBufferSize)
+		: ArrayBufferAllocator(JSArrayBufferAllocatorKind::Pooled)
+		, MaxPooledBytes(maxPooledBytes)
+		, LargeBufferSize(largeBufferSize)
+	{
 	}
 
-	virtual ~JSContext() override
+	virtual ~PooledArrayBufferAllocator()
 	{
-		auto oldData = DebugMessageHandlerData;
-		DebugMessageHandler = nullptr;
-		DebugMessageHandlerData = nullptr;
-		if (ExternalFinalizer != nullptr && oldData != nullptr)
-			ExternalFinalizer(oldData);
-		Handle.Reset();
+		Trim();
+	}
 
-		Isolate->Dispose();
-		Isolate = nullptr;
+	static int ClassIndex(size_t length)
+	{
+		auto classSize = MinClassSize;
+		for (int i = 0; i < ClassCount; ++i, classSize <<= 1)
+		{
+			if (length <= classSize)
+				return i;
+		}
+		return -1;
 	}
 
-	inline v8::Local<v8::Context> LocalHandle() { return Handle.Get(Isolate); }
-};
+	bool IsLarge(size_t length) const
+	{
+		return LargeBufferSize > 0 && length >= LargeBufferSize;
+	}
 
-struct V8Scope
-{
-	V8Scope(v8::Isolate* isolate, const ResettingPersistent<v8::Context>& context)
-		: Locker(isolate)
-		, IsolateScope(isolate)
-		, HandleScope(isolate)
-		, ContextScope(context.Get(isolate))
+	static void* MapPages(size_t length)
 	{
+#ifdef _WIN32
+		return VirtualAlloc(nullptr, length, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+		auto data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return data == MAP_FAILED ? nullptr : data;
+#endif
 	}
-	V8Scope(JSContext* context)
-		: V8Scope(context->Isolate, context->Handle)
+
+	static void UnmapPages(void* data, size_t length)
 	{
+#ifdef _WIN32
+		VirtualFree(data, 0, MEM_RELEASE);
+#else
+		munmap(data, length);
+#endif
 	}
-	v8::Locker Locker;
-	v8::Isolate::Scope IsolateScope;
-	v8::HandleScope HandleScope;
-	v8::Context::Scope ContextScope;
-};
 
-struct JSValue : RefCounted
-{
-	virtual JSType Type() const = 0;
-};
+	void* AllocateBlock(size_t length, bool zero)
+	{
+		void* data = nullptr;
+		auto index = ClassIndex(length);
+		if (index >= 0)
+		{
+			auto classSize = MinClassSize << index;
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				auto& pool = Pools[index];
+				if (!pool.empty())
+				{
+					data = pool.back();
+					pool.pop_back();
+					PooledBytes -= static_cast<int64_t>(classSize);
+				}
+			}
+			if (data != nullptr)
+			{
+				++PoolHitCount;
+				if (zero)
+					memset(data, 0, length);
+			}
+			else
+				data = zero ? calloc(classSize, 1) : malloc(classSize);
+		}
+		else if (IsLarge(length))
+		{
+			// Fresh pages are always zeroed
+			data = MapPages(length);
+			if (data != nullptr)
+				++LargeAllocationCount;
+		}
+		else
+			data = zero ? calloc(length, 1) : malloc(length);
+		return Allocated(data, length);
+	}
 
-struct JSInt : JSValue
-{
-	virtual JSType Type() const override { return JSType::Int; }
-	const int Value;
-	JSInt(int value) : Value(value) { }
-};
+	virtual void* Allocate(size_t length)
+	{
+		return AllocateBlock(length, true);
+	}
 
-struct JSDouble : JSValue
-{
-	virtual JSType Type() const override { return JSType::Double; }
-	const double Value;
-	JSDouble(double value) : Value(value) { }
-};
+	virtual void* AllocateUninitialized(size_t length)
+	{
+		return AllocateBlock(length, false);
+	}
 
-struct JSString : JSValue
-{
-	virtual JSType Type() const override { return JSType::String; }
-	const ResettingPersistent<v8::String> Handle;
-	JSString(v8::Isolate* isolate, const v8::Local<v8::String>& handle)
-		: Handle(isolate, handle)
+	virtual void Free(void* data, size_t length)
 	{
+		if (data == nullptr)
+			return;
+		Freed(data, length);
+		auto index = ClassIndex(length);
+		if (index >= 0)
+		{
+			auto classSize = MinClassSize << index;
+			{
+				std::lock_guard<std::mutex> lock(Mutex);
+				if (static_cast<size_t>(PooledBytes) + classSize <= MaxPooledBytes)
+				{
+					Pools[index].push_back(data);
+					PooledBytes += static_cast<int64_t>(classSize);
+					return;
+				}
+			}
+			free(data);
+		}
+		else if (IsLarge(length))
+			UnmapPages(data, length);
+		else
+			free(data);
 	}
-	inline v8::Local<v8::String> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
-	inline v8::Local<v8::String> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
-};
 
-struct JSBool : JSValue
-{
-	virtual JSType Type() const override { return JSType::Bool; }
-	const bool Value;
-	JSBool(bool value) : Value(value) { }
-};
+	// Buffers are freed by size, so both must map the same sizes
+	virtual bool CanFree(const ArrayBufferAllocator* other) const override
+	{
+		return other->Kind == JSArrayBufferAllocatorKind::Pooled
+			&& static_cast<const PooledArrayBufferAllocator*>(other)->LargeBufferSize == LargeBufferSize;
+	}
 
-struct JSObject : JSValue
-{
-	virtual JSType Type() const override { return JSType::Object; }
-	const ResettingPersistent<v8::Object> Handle;
-	JSObject(v8::Isolate* isolate, const v8::Local<v8::Object>& handle)
-		: Handle(isolate, handle)
+	virtual void Trim() override
 	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		for (auto& pool: Pools)
+		{
+			for (auto data: pool)
+				free(data);
+			pool.clear();
+		}
+		PooledBytes = 0;
 	}
-	inline v8::Local<v8::Object> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
-	inline v8::Local<v8::Object> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
 };
 
-struct JSArray : JSValue
+v8::Platform* _platform = nullptr;
+static std::once_flag _initializeOnce;
+
+// Safe to call from several threads creating their first contexts at once.
+// Returns false if V8 was already initialized.
+static bool InitializeV8(int threadCount = 0, const char* flags = nullptr)
 {
-	virtual JSType Type() const override { return JSType::Array; }
-	ResettingPersistent<v8::Array> Handle;
-	JSArray(v8::Isolate* isolate, const v8::Local<v8::Array>& handle)
-		: Handle(isolate, handle)
+	auto initialized = false;
+	std::call_once(_initializeOnce, [&] ()
 	{
-	}
-	inline v8::Local<v8::Array> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
-	inline v8::Local<v8::Array> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
-};
+		if (flags != nullptr)
+			v8::V8::SetFlagsFromString(flags, static_cast<int>(strlen(flags)));
+		v8::V8::InitializeICU();
+		_platform = v8::platform::CreateDefaultPlatform(threadCount);
+		v8::V8::InitializePlatform(_platform);
+		v8::V8::Initialize();
+		initialized = true;
+	});
+	return initialized;
+}
 
-struct JSFunction : JSValue
+inline InstrumentedCall::InstrumentedCall(JSInstrumentedCall call, const char* name)
+	: Call(call)
+	, Name(name)
+	, Timed(InstrumentationEnabled())
+	, TraceCategory(nullptr)
+	, TraceHandle(0)
 {
-	virtual JSType Type() const override { return JSType::Function; }
-	ResettingPersistent<v8::Function> Handle;
-	JSFunction(v8::Isolate* isolate, const v8::Local<v8::Function>& handle)
-		: Handle(isolate, handle)
+	if (TraceEnabled())
 	{
+		TraceCategory = _traceCategory.load();
+		TraceHandle = _platform->AddTraceEvent(
+			'X', TraceCategory, Name, nullptr, 0, 0, 0, nullptr, nullptr, nullptr, nullptr, 0);
 	}
-	inline v8::Local<v8::Function> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
-	inline v8::Local<v8::Function> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
-};
+	if (Timed)
+		Start = std::chrono::steady_clock::now();
+}
 
-struct JSExternal : JSValue
+inline InstrumentedCall::~InstrumentedCall()
 {
-	virtual JSType Type() const override { return JSType::External; }
-	ResettingPersistent<v8::External> Handle;
-	JSExternal(v8::Isolate* isolate, const v8::Local<v8::External>& handle)
-		: Handle(isolate, handle)
+	if (Timed)
 	{
+		auto elapsed = std::chrono::steady_clock::now() - Start;
+		auto& counter = _callCounters[static_cast<int>(Call)];
+		counter.Calls.fetch_add(1, std::memory_order_relaxed);
+		counter.Nanoseconds.fetch_add(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+			std::memory_order_relaxed);
 	}
-	inline v8::Local<v8::External> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
-	inline v8::Local<v8::External> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
-};
+	if (TraceHandle != 0)
+		_platform->UpdateTraceEventDuration(TraceCategory, Name, TraceHandle);
+}
 
-struct JSScriptException : RefCounted
+// Using this and not plain v8::Persistents ensures that the references are
+// reset in the destructor.
+template<class T>
+using ResettingPersistent = v8::Persistent<T, v8::CopyablePersistentTraits<T>>;
+
+// Keeps the isolate locked and entered on one thread between
+// BeginJSContextSession and the matching EndJSContextSession.
+struct JSContextSession
 {
-	JSValue* Exception;
-	JSString* ErrorMessage;
-	JSString* FileName;
-	int LineNumber;
-	JSString* StackTrace;
-	JSString* SourceLine;
+	v8::Locker Locker;
+	v8::Isolate::Scope IsolateScope;
+	int Depth;
 
-	// Note: Assumes that all arguments are retained
-	JSScriptException(
-		JSValue* exception,
-		JSString* errorMessage,
-		JSString* fileName,
-		int lineNumber,
-		JSString* stackTrace,
-		JSString* sourceLine)
-		: Exception(exception)
-		, ErrorMessage(errorMessage)
-		, FileName(fileName)
-		, LineNumber(lineNumber)
-		, StackTrace(stackTrace)
-		, SourceLine(sourceLine)
+	JSContextSession(v8::Isolate* isolate)
+		: Locker(isolate)
+		, IsolateScope(isolate)
+		, Depth(1)
 	{
 	}
+};
 
-	~JSScriptException()
-	{
-		if (Exception != nullptr) Exception->Release();
-		if (ErrorMessage != nullptr) ErrorMessage->Release();
-		if (FileName != nullptr) FileName->Release();
-		if (StackTrace != nullptr) StackTrace->Release();
-		if (SourceLine != nullptr) SourceLine->Release();
-	}
+static void PoolContextDisposed(JSContextPool* pool);
+static void UpdateGCCallbacks(JSContext* context);
+struct JSExecutor;
+static void DeleteExecutor(JSExecutor* executor);
+struct JSModule;
+
+// A last reference released by a thread that didn't hold the isolate lock
+// while another thread did, see JSContext::DeferRelease
+struct DeferredRelease
+{
+	RefCounted* const Object;
+	DeferredRelease* Next;
 };
 
-template<typename T>
-inline static auto TryCatch(
-	JSScriptException** outError,
-	const V8Scope& scope,
-	T inner) -> decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr))
+// Terminates script that runs past a deadline. Runs on its own thread, and
+// is armed by the outermost call into script on the context.
+struct JSWatchdog
 {
-	*outError = nullptr;
-	try
+	v8::Isolate* const Isolate;
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::chrono::steady_clock::time_point Deadline;
+	bool Armed;
+	bool Fired;
+	bool Stopping;
+	std::thread Thread;
+
+	JSWatchdog(v8::Isolate* isolate)
+		: Isolate(isolate)
+		, Armed(false)
+		, Fired(false)
+		, Stopping(false)
+		, Thread([this] { Run(); })
 	{
-		v8::TryCatch tryCatch;
-		return inner(tryCatch);
 	}
-	catch (JSScriptException* exception)
+
+	~JSWatchdog()
 	{
-		*outError = exception;
-		return decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr))();
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Stopping = true;
+		}
+		Condition.notify_one();
+		Thread.join();
 	}
-}
-
-template<typename T>
-inline static auto TryCatch(
-	JSScriptException** outError,
-	JSContext* context,
-	T inner) -> decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr))
-{
-	V8Scope scope(context);
-	return TryCatch(outError, scope, inner);
-}
-
-static JSValue* Wrap(JSContext* context, const v8::TryCatch& tryCatch, v8::Local<v8::Value> value);
-
-static void Throw(JSContext* context, const v8::TryCatch& tryCatch)
-{
-	v8::Local<v8::String> emptyString = v8::String::Empty(context->Isolate);
 
-	v8::Local<v8::Message> message = tryCatch.Message();
-	v8::Local<v8::String> sourceLine(emptyString);
-	v8::Local<v8::String> messageStr(emptyString);
-	v8::Local<v8::String> fileName(emptyString);
-	int lineNumber = -1;
-	auto localContext = context->LocalHandle();
-	if (!message.IsEmpty())
+	void Arm(int milliseconds)
 	{
-		sourceLine = message->GetSourceLine(localContext).FromMaybe(emptyString);
-		auto messageStrLocal = message->Get();
-		if (!messageStrLocal.IsEmpty())
 		{
-			messageStr = messageStrLocal;
+			std::lock_guard<std::mutex> lock(Mutex);
+			Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+			Armed = true;
+			Fired = false;
 		}
-		fileName = message->GetScriptResourceName()->ToString(localContext).FromMaybe(emptyString);
-		lineNumber = message->GetLineNumber(localContext).FromMaybe(-1);
+		Condition.notify_one();
 	}
 
-	JSValue* exception = nullptr;
-	if (!tryCatch.Exception().IsEmpty())
+	// Returns true if the deadline passed before disarming
+	bool Disarm()
 	{
-		v8::TryCatch innerTryCatch;
-		exception = Wrap(context, innerTryCatch, tryCatch.Exception());
+		std::lock_guard<std::mutex> lock(Mutex);
+		Armed = false;
+		return Fired;
 	}
 
-	v8::Local<v8::String> stackTrace(
-		tryCatch
-		.StackTrace(localContext)
-		.FromMaybe(emptyString.As<v8::Value>())
-		->ToString(localContext)
-		.FromMaybe(emptyString));
-
-	throw new JSScriptException(
-		exception,
-		new JSString(context->Isolate, messageStr),
-		new JSString(context->Isolate, fileName),
-		lineNumber,
-		new JSString(context->Isolate, stackTrace),
-		new JSString(context->Isolate, sourceLine));
-}
-
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		while (!Stopping)
+		{
+			if (!Armed)
+			{
+				Condition.wait(lock);
+			}
+			else if (Condition.wait_until(lock, Deadline) == std::cv_status::timeout
+				&& Armed
+				&& std::chrono::steady_clock::now() >= Deadline)
+			{
+				Armed = false;
+				Fired = true;
+				Isolate->TerminateExecution();
+			}
+		}
+	}
+};
+
+// The data of a JSClass method or accessor. Owned by the context, because
+// V8 keeps templates alive for as long as the isolate.
+struct JSClassCallback
+{
+	JSContext* Context;
+	void* Data;
+	JSCallback Callback;
+};
+
+// An object wrapper's registration in its context's identity cache. The
+// wrapper unregisters itself when it's destroyed.
+struct IdentityCacheEntry
+{
+	JSContext* Context;
+	JSValue* Wrapper;
+	int Hash;
+
+	IdentityCacheEntry()
+		: Context(nullptr)
+		, Wrapper(nullptr)
+		, Hash(0)
+	{
+	}
+
+	IdentityCacheEntry(const IdentityCacheEntry&) = delete;
+	IdentityCacheEntry& operator=(const IdentityCacheEntry&) = delete;
+
+	void Unregister();
+};
+
+struct JSContext : RefCounted
+{
+	const JSCallbackFinalizer CallbackFinalizer;
+	const JSExternalFinalizer ExternalFinalizer;
+	v8::Isolate* Isolate;
+	ResettingPersistent<v8::Context> Handle;
+	JSDebugMessageHandler DebugMessageHandler;
+	void* DebugMessageHandlerData;
+	// Only read or written by the thread holding the isolate lock
+	JSContextSession* Session;
+	// V8 deserializes contexts from the startup snapshot lazily, so it has to
+	// stay alive as long as the isolate.
+	std::vector<char> SnapshotData;
+	v8::StartupData SnapshotBlob;
+	// The pool the context was acquired from, if any. Holds a reference to
+	// the pool while the context is in use, but not while it's idle in the
+	// pool.
+	JSContextPool* Pool;
+	// Live object, array and function wrappers by identity hash, so the same
+	// V8 object is returned as the same wrapper. Only used when enabled, and
+	// only accessed by the thread holding the isolate lock.
+	bool IdentityCacheEnabled;
+	std::unordered_multimap<int, IdentityCacheEntry*> IdentityCache;
+	// Internalized strings from CreateJSPropertyKey, each holding a reference.
+	// Only accessed by the thread holding the isolate lock.
+	std::unordered_map<std::u16string, JSString*> PropertyKeys;
+	std::vector<JSClassCallback*> ClassCallbacks;
+	JSGCEventHandler GCEventHandler;
+	void* GCEventHandlerData;
+	std::chrono::steady_clock::time_point GCStart;
+	bool GCCallbacksInstalled;
+	JSOOMErrorHandler OOMErrorHandler;
+	JSNearHeapLimitHandler NearHeapLimitHandler;
+	void* NearHeapLimitHandlerData;
+	int NearHeapLimitPercent;
+	bool NearHeapLimitReported;
+	ArrayBufferAllocator* Allocator;
+	// Held by the creating thread for the whole life of a single-threaded
+	// context, so that calls don't have to lock
+	v8::Locker* OwnerLocker;
+	// Created by the first StartJSCpuProfile
+	v8::CpuProfiler* CpuProfiler;
+	// Titles of the CPU profiles that have been started and not stopped
+	std::vector<ResettingPersistent<v8::String>> CpuProfileTitles;
+	// Calls into script currently on the stack. Written by the thread holding
+	// the isolate lock, read from any thread by TerminateJSExecution.
+	std::atomic_int ExecutionDepth;
+	// Held by TerminateJSExecution and by the outermost call into script
+	// while it finishes, so that a termination either hits the running call
+	// or is cancelled when it returns, never the next call
+	std::mutex TerminationMutex;
+	// Set by TerminateJSExecution, under TerminationMutex
+	bool TerminationRequested;
+	// Per-call time limit in milliseconds, or 0
+	int Timeout;
+	// JSContextOptions::StackSize, and the thread whose stack the limit was
+	// last set for. Only accessed by the thread holding the isolate lock.
+	int StackSize;
+	std::thread::id StackLimitThread;
+	JSWatchdog* Watchdog;
+	// Created by StartJSContextExecutor
+	JSExecutor* Executor;
+	// Set by SetJSModuleLoader
+	JSModuleResolver ModuleResolver;
+	JSModuleLoader ModuleLoader;
+	void* ModuleLoaderData;
+	// Modules loaded by require, by file name. Only accessed by the thread
+	// holding the isolate lock.
+	std::unordered_map<std::u16string, JSModule*> Modules;
+	// Threads holding, or waiting for, the isolate lock through
+	// IsolateEntry, a session or OwnerLocker
+	std::atomic_int LockHolders;
+	// Last references released from other threads while the isolate was in
+	// use. Pushed without locking, and released in one batch by the thread
+	// holding the lock when it next enters a V8Scope or unlocks.
+	std::atomic<DeferredRelease*> PendingReleases;
+
+	JSContext(
+		JSCallbackFinalizer callbackFinalizer,
+		JSExternalFinalizer externalFinalizer,
+		const uint8_t* snapshotData = nullptr,
+		int snapshotLength = 0,
+		const JSContextOptions* options = nullptr)
+		: CallbackFinalizer(callbackFinalizer)
+		, ExternalFinalizer(externalFinalizer)
+		, DebugMessageHandler(nullptr)
+		, DebugMessageHandlerData(nullptr)
+		, Session(nullptr)
+		, SnapshotData(snapshotData, snapshotData + (snapshotData == nullptr ? 0 : snapshotLength))
+		, SnapshotBlob{nullptr, 0}
+		, Pool(nullptr)
+		, IdentityCacheEnabled(false)
+		, GCEventHandler(nullptr)
+		, GCEventHandlerData(nullptr)
+		, GCCallbacksInstalled(false)
+		, OOMErrorHandler(nullptr)
+		, NearHeapLimitHandler(nullptr)
+		, NearHeapLimitHandlerData(nullptr)
+		, NearHeapLimitPercent(90)
+		, NearHeapLimitReported(false)
+		, Allocator(nullptr)
+		, OwnerLocker(nullptr)
+		, CpuProfiler(nullptr)
+		, ExecutionDepth(0)
+		, TerminationRequested(false)
+		, Timeout(0)
+		, StackSize(0)
+		, Watchdog(nullptr)
+		, Executor(nullptr)
+		, ModuleResolver(nullptr)
+		, ModuleLoader(nullptr)
+		, ModuleLoaderData(nullptr)
+		, LockHolders(0)
+		, PendingReleases(nullptr)
+	{
+		InitializeV8();
+
+		if (options != nullptr && options->ArrayBufferAllocator == JSArrayBufferAllocatorKind::Pooled)
+		{
+			auto poolSize = options->ArrayBufferPoolSize > 0 ? options->ArrayBufferPoolSize : 1024;
+			Allocator = new PooledArrayBufferAllocator(
+				static_cast<size_t>(poolSize) * 1024,
+				static_cast<size_t>(options->LargeArrayBufferSize) * 1024);
+		}
+		else
+			Allocator = new ArrayBufferAllocator();
+		v8::Isolate::CreateParams createParams;
+		createParams.array_buffer_allocator = Allocator;
+		if (!SnapshotData.empty())
+		{
+			SnapshotBlob.data = &SnapshotData[0];
+			SnapshotBlob.raw_size = static_cast<int>(SnapshotData.size());
+			createParams.snapshot_blob = &SnapshotBlob;
+		}
+		if (options != nullptr)
+		{
+			auto& constraints = createParams.constraints;
+			if (options->MaxSemiSpaceSize > 0)
+				constraints.set_max_semi_space_size(options->MaxSemiSpaceSize);
+			if (options->MaxOldSpaceSize > 0)
+				constraints.set_max_old_space_size(options->MaxOldSpaceSize);
+			if (options->CodeRangeSize > 0)
+				constraints.set_code_range_size(static_cast<size_t>(options->CodeRangeSize));
+			if (options->StackSize > 0)
+			{
+				// V8 takes the lowest address the stack may grow down to. Other
+				// threads get their limit when they lock the isolate.
+				StackSize = options->StackSize;
+				StackLimitThread = std::this_thread::get_id();
+				auto stackPosition = reinterpret_cast<uintptr_t>(&createParams);
+				constraints.set_stack_limit(reinterpret_cast<uint32_t*>(
+					stackPosition - static_cast<uintptr_t>(StackSize) * 1024));
+			}
+			OOMErrorHandler = options->OOMErrorHandler;
+			NearHeapLimitHandler = options->NearHeapLimitHandler;
+			NearHeapLimitHandlerData = options->NearHeapLimitHandlerData;
+			if (options->NearHeapLimitPercent > 0)
+				NearHeapLimitPercent = options->NearHeapLimitPercent;
+		}
+		Isolate = v8::Isolate::New(createParams);
+		// For the isolate callbacks that don't take a data pointer
+		Isolate->SetData(0, this);
+		if (options != nullptr && options->SingleThreaded)
+		{
+			++LockHolders;
+			OwnerLocker = new v8::Locker(Isolate);
+		}
+
+		v8::Locker locker(Isolate);
+		v8::Isolate::Scope isolateScope(Isolate);
+		v8::HandleScope handleScope(Isolate);
+
+		auto localContext = NewLocalContext();
+		v8::Context::Scope contextScope(localContext);
+
+		Handle.Reset(Isolate, localContext);
+	}
+
+	// Forgets all cached wrappers. They stay valid, but are no longer
+	// returned for their objects.
+	void ClearIdentityCache()
+	{
+		for (auto& cached : IdentityCache)
+			cached.second->Context = nullptr;
+		IdentityCache.clear();
+	}
+
+	// Creates a context from the startup snapshot if there is one, otherwise
+	// an empty context. Requires an entered isolate and a HandleScope.
+	v8::Local<v8::Context> NewLocalContext()
+	{
+		v8::Local<v8::Context> localContext;
+		if (SnapshotData.empty() || !v8::Context::FromSnapshot(Isolate, 0).ToLocal(&localContext))
+			localContext = v8::Context::New(Isolate);
+		return localContext;
+	}
+
+	virtual ~JSContext() override
+	{
+		// First, while the executor's queued calls can still be released. It
+		// locks the isolate on its own thread.
+		DeleteExecutor(Executor);
+		Executor = nullptr;
+
+		{
+			// Resetting handles requires the lock, which has to be given up
+			// before the isolate is disposed. Lockers nest, so this does
+			// nothing if the calling thread holds it already.
+			v8::Locker locker(Isolate);
+			DrainReleases();
+
+			auto oldData = DebugMessageHandlerData;
+			DebugMessageHandler = nullptr;
+			DebugMessageHandlerData = nullptr;
+			if (ExternalFinalizer != nullptr && oldData != nullptr)
+				ExternalFinalizer(oldData);
+			auto oldGCData = GCEventHandlerData;
+			GCEventHandler = nullptr;
+			GCEventHandlerData = nullptr;
+			if (ExternalFinalizer != nullptr && oldGCData != nullptr)
+				ExternalFinalizer(oldGCData);
+			auto oldHeapLimitData = NearHeapLimitHandlerData;
+			NearHeapLimitHandler = nullptr;
+			NearHeapLimitHandlerData = nullptr;
+			if (ExternalFinalizer != nullptr && oldHeapLimitData != nullptr)
+				ExternalFinalizer(oldHeapLimitData);
+			auto oldModuleData = ModuleLoaderData;
+			ModuleResolver = nullptr;
+			ModuleLoader = nullptr;
+			ModuleLoaderData = nullptr;
+			if (ExternalFinalizer != nullptr && oldModuleData != nullptr)
+				ExternalFinalizer(oldModuleData);
+			ClearIdentityCache();
+			ReleasePropertyKeys();
+			ClearModules();
+			for (auto callback : ClassCallbacks)
+			{
+				if (CallbackFinalizer != nullptr)
+					CallbackFinalizer(callback->Data);
+				delete callback;
+			}
+			ClassCallbacks.clear();
+			Handle.Reset();
+
+			if (CpuProfiler != nullptr)
+			{
+				StopCpuProfiles();
+				CpuProfiler->Dispose();
+			}
+			CpuProfiler = nullptr;
+		}
+
+		delete Session;
+		Session = nullptr;
+
+		delete Watchdog;
+		Watchdog = nullptr;
+
+		delete OwnerLocker;
+		OwnerLocker = nullptr;
+
+		Isolate->Dispose();
+		Isolate = nullptr;
+
+		// The isolate frees its remaining buffers when disposed
+		Allocator->Release();
+		Allocator = nullptr;
+
+		if (Pool != nullptr)
+			PoolContextDisposed(Pool);
+	}
+
+	inline v8::Local<v8::Context> LocalHandle() { return Handle.Get(Isolate); }
+
+	// Limits the stack of the calling thread to StackSize below the caller,
+	// unless the limit was last set for this thread. Requires the isolate
+	// lock.
+	void SetThreadStackLimit()
+	{
+		if (StackSize <= 0 || StackLimitThread == std::this_thread::get_id())
+			return;
+		char stackPosition;
+		Isolate->SetStackLimit(
+			reinterpret_cast<uintptr_t>(&stackPosition) - static_cast<uintptr_t>(StackSize) * 1024);
+		StackLimitThread = std::this_thread::get_id();
+	}
+
+	// Takes over the last reference to object, for the thread holding the
+	// isolate lock to release
+	void DeferRelease(RefCounted* object)
+	{
+		auto release = new DeferredRelease{object, PendingReleases.load()};
+		while (!PendingReleases.compare_exchange_weak(release->Next, release))
+		{
+		}
+	}
+
+	// Releases the deferred references and returns how many there were.
+	// Requires the isolate lock.
+	int DrainReleases()
+	{
+		if (PendingReleases.load(std::memory_order_relaxed) == nullptr)
+			return 0;
+		auto releases = PendingReleases.exchange(nullptr);
+		int count = 0;
+		while (releases != nullptr)
+		{
+			auto release = releases;
+			releases = release->Next;
+			release->Object->Release();
+			delete release;
+			++count;
+		}
+		return count;
+	}
+
+	void ReleasePropertyKeys();
+	void ClearModules();
+	void StopCpuProfiles();
+};
+
+void IdentityCacheEntry::Unregister()
+{
+	if (Context == nullptr)
+		return;
+	auto range = Context->IdentityCache.equal_range(Hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second == this)
+		{
+			Context->IdentityCache.erase(it);
+			break;
+		}
+	}
+	Context = nullptr;
+}
+
+// Locks and enters the isolate, skipping whatever the calling thread already
+// has: the lock is held for good by single-threaded contexts and during
+// sessions, and the isolate is entered further up the stack when calling
+// back into V8 from a JSCallback. Releases deferred while the lock was held
+// are drained before unlocking.
+struct IsolateEntry
+{
+	IsolateEntry(v8::Isolate* isolate)
+		: _context(static_cast<JSContext*>(isolate->GetData(0)))
+		, _alreadyLocked(v8::Locker::IsLocked(isolate))
+		, _alreadyEntered(_alreadyLocked && v8::Isolate::GetCurrent() == isolate)
+	{
+		if (!_alreadyLocked)
+		{
+			++_context->LockHolders;
+			new (&_locker) v8::Locker(isolate);
+		}
+		if (!_alreadyEntered)
+			new (&_isolateScope) v8::Isolate::Scope(isolate);
+		if (!_alreadyLocked)
+			_context->SetThreadStackLimit();
+	}
+
+	~IsolateEntry()
+	{
+		if (!_alreadyLocked)
+		{
+			// Releases deferred after this drain are seen by the releasing
+			// thread, see ReleaseFromAnyThread
+			--_context->LockHolders;
+			_context->DrainReleases();
+		}
+		if (!_alreadyEntered)
+			reinterpret_cast<v8::Isolate::Scope*>(&_isolateScope)->~Scope();
+		if (!_alreadyLocked)
+			reinterpret_cast<v8::Locker*>(&_locker)->~Locker();
+	}
+
+	IsolateEntry(const IsolateEntry&) = delete;
+	IsolateEntry& operator=(const IsolateEntry&) = delete;
+
+private:
+	JSContext* const _context;
+	const bool _alreadyLocked;
+	const bool _alreadyEntered;
+	std::aligned_storage<sizeof(v8::Locker), alignof(v8::Locker)>::type _locker;
+	std::aligned_storage<sizeof(v8::Isolate::Scope), alignof(v8::Isolate::Scope)>::type _isolateScope;
+};
+
+struct V8Scope
+{
+	V8Scope(v8::Isolate* isolate, const ResettingPersistent<v8::Context>& context)
+		: Entry(isolate)
+		, HandleScope(isolate)
+		, ContextScope(context.Get(isolate))
+	{
+		static_cast<JSContext*>(isolate->GetData(0))->DrainReleases();
+	}
+	V8Scope(JSContext* context)
+		: V8Scope(context->Isolate, context->Handle)
+	{
+	}
+	IsolateEntry Entry;
+	v8::HandleScope HandleScope;
+	v8::Context::Scope ContextScope;
+};
+
+// Counts the calls into script on the stack. The outermost one arms the
+// watchdog, and cancels any termination when it's done so that the context
+// can be used again.
+struct ExecutionScope
+{
+	JSContext* const Context;
+
+	ExecutionScope(JSContext* context)
+		: Context(context)
+	{
+		if (Context->ExecutionDepth++ == 0 && Context->Timeout > 0)
+			Context->Watchdog->Arm(Context->Timeout);
+	}
+
+	~ExecutionScope()
+	{
+		// Only this thread changes the depth, so this is the outermost call
+		if (Context->ExecutionDepth.load() != 1)
+		{
+			--Context->ExecutionDepth;
+			return;
+		}
+		std::lock_guard<std::mutex> lock(Context->TerminationMutex);
+		--Context->ExecutionDepth;
+		auto timedOut = Context->Watchdog != nullptr && Context->Watchdog->Disarm();
+		// A termination requested just before returning may not have been
+		// seen by V8 yet
+		if (timedOut || Context->TerminationRequested || Context->Isolate->IsExecutionTerminating())
+			Context->Isolate->CancelTerminateExecution();
+		Context->TerminationRequested = false;
+	}
+
+	ExecutionScope(const ExecutionScope&) = delete;
+	ExecutionScope& operator=(const ExecutionScope&) = delete;
+};
+
+// Heap allocated values are at least 8-byte aligned, which leaves the low
+// three bits of a JSValue* free to tag immediate values (see below).
+struct alignas(8) JSValue : RefCounted
+{
+	JSValue()
+	{
+		if (InstrumentationEnabled())
+			_wrapperAllocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	virtual JSType Type() const = 0;
+};
+
+// Boxed ints and doubles, for the values that don't fit in an immediate
+struct JSInt : JSValue
+{
+	virtual JSType Type() const override { return JSType::Int; }
+	const int Value;
+	JSInt(int value) : Value(value) { }
+};
+
+struct JSDouble : JSValue
+{
+	virtual JSType Type() const override { return JSType::Double; }
+	const double Value;
+	JSDouble(double value) : Value(value) { }
+};
+
+// -------------------------------------------------------------------------
+// Immediate values
+//
+// Ints, bools and (on 64-bit platforms) most doubles are encoded directly in
+// the JSValue pointer, so creating, retaining and releasing them never
+// touches the heap. The low three bits of the pointer hold the tag:
+//
+//   ...000  heap allocated JSValue (or nullptr for Null)
+//   ...001  Int, the value is in the upper bits
+//   ...010  Bool, the value is in bit 3
+//   ...100  Double, see EncodeDouble
+static const uintptr_t ImmediateTagBits = 3;
+static const uintptr_t ImmediateTagMask = (1 << ImmediateTagBits) - 1;
+static const uintptr_t ImmediateIntTag = 1;
+static const uintptr_t ImmediateBoolTag = 2;
+static const uintptr_t ImmediateDoubleTag = 4;
+
+static inline uintptr_t ImmediateTag(const JSValue* value)
+{
+	return reinterpret_cast<uintptr_t>(value) & ImmediateTagMask;
+}
+
+static inline bool IsImmediate(const JSValue* value)
+{
+	return ImmediateTag(value) != 0;
+}
+
+static inline JSValue* MakeImmediate(uintptr_t payload, uintptr_t tag)
+{
+	return reinterpret_cast<JSValue*>((payload << ImmediateTagBits) | tag);
+}
+
+static inline uintptr_t ImmediatePayload(const JSValue* value)
+{
+	return reinterpret_cast<uintptr_t>(value) >> ImmediateTagBits;
+}
+
+static inline JSValue* NewJSInt(int value)
+{
+	const intptr_t maxImmediateInt = INTPTR_MAX >> ImmediateTagBits;
+	const intptr_t minImmediateInt = INTPTR_MIN >> ImmediateTagBits;
+	if (value > maxImmediateInt || value < minImmediateInt)
+		return new JSInt(value);
+	return MakeImmediate(static_cast<uintptr_t>(static_cast<intptr_t>(value)), ImmediateIntTag);
+}
+
+static inline int IntValue(const JSValue* value)
+{
+	if (ImmediateTag(value) == ImmediateIntTag)
+		return static_cast<int>(reinterpret_cast<intptr_t>(value) >> ImmediateTagBits);
+	return static_cast<const JSInt*>(value)->Value;
+}
+
+static inline JSValue* NewJSBool(bool value)
+{
+	return MakeImmediate(value ? 1 : 0, ImmediateBoolTag);
+}
+
+static inline bool BoolValue(const JSValue* value)
+{
+	return ImmediatePayload(value) != 0;
+}
+
+// Doubles are only immediate when pointers are 64 bits wide. The 61 bits of
+// payload fit the sign, the full 52 bit mantissa and an 8 bit exponent, which
+// covers zero and all numbers with a magnitude between roughly 1e-38 and 1e38.
+// Everything else (denormals, infinities, NaN, very large or small numbers)
+// is boxed in a JSDouble.
+static const uint64_t DoubleMantissaBits = 52;
+static const uint64_t DoubleMantissaMask = (uint64_t(1) << DoubleMantissaBits) - 1;
+static const uint64_t DoubleExponentMask = 0x7FF;
+static const uint64_t ImmediateExponentBias = 896;
+static const uint64_t ImmediateExponentMax = 255;
+
+static inline bool EncodeDouble(double value, uintptr_t* outPayload)
+{
+	if (sizeof(uintptr_t) < sizeof(uint64_t))
+		return false;
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	auto sign = bits >> 63;
+	auto exponent = (bits >> DoubleMantissaBits) & DoubleExponentMask;
+	auto mantissa = bits & DoubleMantissaMask;
+	uint64_t immediateExponent;
+	if (exponent == 0 && mantissa == 0)
+		immediateExponent = 0;
+	else if (exponent > ImmediateExponentBias && exponent - ImmediateExponentBias <= ImmediateExponentMax)
+		immediateExponent = exponent - ImmediateExponentBias;
+	else
+		return false;
+	*outPayload = static_cast<uintptr_t>(
+		(immediateExponent << (DoubleMantissaBits + 1)) | (mantissa << 1) | sign);
+	return true;
+}
+
+static inline double DecodeDouble(uintptr_t payload)
+{
+	uint64_t p = payload;
+	auto sign = p & 1;
+	auto mantissa = (p >> 1) & DoubleMantissaMask;
+	auto immediateExponent = p >> (DoubleMantissaBits + 1);
+	auto exponent = immediateExponent == 0 ? 0 : immediateExponent + ImmediateExponentBias;
+	uint64_t bits = (sign << 63) | (exponent << DoubleMantissaBits) | mantissa;
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static inline JSValue* NewJSDouble(double value)
+{
+	uintptr_t payload;
+	if (EncodeDouble(value, &payload))
+		return MakeImmediate(payload, ImmediateDoubleTag);
+	return new JSDouble(value);
+}
+
+static inline double DoubleValue(const JSValue* value)
+{
+	if (ImmediateTag(value) == ImmediateDoubleTag)
+		return DecodeDouble(ImmediatePayload(value));
+	return static_cast<const JSDouble*>(value)->Value;
+}
+
+static inline void RetainValue(JSValue* value)
+{
+	if (value != nullptr && !IsImmediate(value))
+		value->Retain();
+}
+
+static inline void ReleaseValue(JSValue* value)
+{
+	if (value != nullptr && !IsImmediate(value))
+		value->Release();
+}
+
+struct JSString : JSValue
+{
+	virtual JSType Type() const override { return JSType::String; }
+	const ResettingPersistent<v8::String> Handle;
+	JSString(v8::Isolate* isolate, const v8::Local<v8::String>& handle)
+		: Handle(isolate, handle)
+	{
+	}
+	inline v8::Local<v8::String> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
+	inline v8::Local<v8::String> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+void JSContext::ReleasePropertyKeys()
+{
+	for (auto& key : PropertyKeys)
+		key.second->Release();
+	PropertyKeys.clear();
+}
+
+struct JSObject : JSValue
+{
+	virtual JSType Type() const override { return JSType::Object; }
+	const ResettingPersistent<v8::Object> Handle;
+	IdentityCacheEntry CacheEntry;
+	JSObject(v8::Isolate* isolate, const v8::Local<v8::Object>& handle)
+		: Handle(isolate, handle)
+	{
+	}
+	virtual ~JSObject() override { CacheEntry.Unregister(); }
+	inline v8::Local<v8::Object> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
+	inline v8::Local<v8::Object> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+// A JSObject as far as the API is concerned, but whose type says it's a
+// promise
+struct JSPromise : JSObject
+{
+	virtual JSType Type() const override { return JSType::Promise; }
+	JSPromise(v8::Isolate* isolate, const v8::Local<v8::Promise>& handle)
+		: JSObject(isolate, handle)
+	{
+	}
+};
+
+struct JSArray : JSValue
+{
+	virtual JSType Type() const override { return JSType::Array; }
+	ResettingPersistent<v8::Array> Handle;
+	IdentityCacheEntry CacheEntry;
+	JSArray(v8::Isolate* isolate, const v8::Local<v8::Array>& handle)
+		: Handle(isolate, handle)
+	{
+	}
+	virtual ~JSArray() override { CacheEntry.Unregister(); }
+	inline v8::Local<v8::Array> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
+	inline v8::Local<v8::Array> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+struct JSFunction : JSValue
+{
+	virtual JSType Type() const override { return JSType::Function; }
+	ResettingPersistent<v8::Function> Handle;
+	IdentityCacheEntry CacheEntry;
+	JSFunction(v8::Isolate* isolate, const v8::Local<v8::Function>& handle)
+		: Handle(isolate, handle)
+	{
+	}
+	virtual ~JSFunction() override { CacheEntry.Unregister(); }
+	inline v8::Local<v8::Function> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
+	inline v8::Local<v8::Function> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+struct JSExternal : JSValue
+{
+	virtual JSType Type() const override { return JSType::External; }
+	ResettingPersistent<v8::External> Handle;
+	JSExternal(v8::Isolate* isolate, const v8::Local<v8::External>& handle)
+		: Handle(isolate, handle)
+	{
+	}
+	inline v8::Local<v8::External> LocalHandle(v8::Isolate* isolate) { return Handle.Get(isolate); }
+	inline v8::Local<v8::External> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+struct JSPromiseResolver : RefCounted
+{
+	const ResettingPersistent<v8::Promise::Resolver> Handle;
+	JSPromiseResolver(v8::Isolate* isolate, const v8::Local<v8::Promise::Resolver>& handle)
+		: Handle(isolate, handle)
+	{
+	}
+	inline v8::Local<v8::Promise::Resolver> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+// Only keeps the exception and its message when caught. The wrappers and
+// strings are made by the getters the first time they're asked for, since
+// scripts using exceptions for control flow rarely look at them.
+struct JSScriptException : RefCounted
+{
+	JSContext* const Context;
+	const JSScriptExceptionKind Kind;
+	ResettingPersistent<v8::Value> ExceptionHandle;
+	ResettingPersistent<v8::Message> MessageHandle;
+
+	bool ExceptionWrapped;
+	JSValue* Exception;
+	JSString* ErrorMessage;
+	JSString* FileName;
+	JSString* StackTrace;
+	JSString* SourceLine;
+
+	JSScriptException(JSContext* context, JSScriptExceptionKind kind)
+		: Context(context)
+		, Kind(kind)
+		, ExceptionWrapped(false)
+		, Exception(nullptr)
+		, ErrorMessage(nullptr)
+		, FileName(nullptr)
+		, StackTrace(nullptr)
+		, SourceLine(nullptr)
+	{
+	}
+
+	~JSScriptException()
+	{
+		ReleaseValue(Exception);
+		if (ErrorMessage != nullptr) ErrorMessage->Release();
+		if (FileName != nullptr) FileName->Release();
+		if (StackTrace != nullptr) StackTrace->Release();
+		if (SourceLine != nullptr) SourceLine->Release();
+	}
+};
+
+// Keeps released contexts around so that their isolates can be reused
+struct JSContextPool : RefCounted
+{
+	const JSCallbackFinalizer CallbackFinalizer;
+	const JSExternalFinalizer ExternalFinalizer;
+	const int MaxIdleContexts;
+	const bool ResetContexts;
+
+	std::mutex Mutex;
+	std::vector<JSContext*> IdleContexts;
+	JSContextPoolStatistics Statistics;
+
+	JSContextPool(
+		int maxIdleContexts,
+		bool resetContexts,
+		JSCallbackFinalizer callbackFinalizer,
+		JSExternalFinalizer externalFinalizer)
+		: CallbackFinalizer(callbackFinalizer)
+		, ExternalFinalizer(externalFinalizer)
+		, MaxIdleContexts(maxIdleContexts)
+		, ResetContexts(resetContexts)
+		, Statistics{0, 0, 0, 0}
+	{
+	}
+
+	virtual ~JSContextPool() override
+	{
+		std::vector<JSContext*> idleContexts;
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			idleContexts.swap(IdleContexts);
+		}
+		for (auto context : idleContexts)
+		{
+			// Idle contexts don't hold a reference to the pool
+			context->Pool = nullptr;
+			context->Release();
+		}
+	}
+};
+
+// Counts a disposed context out of its pool and releases the context's
+// reference to it
+static void PoolContextDisposed(JSContextPool* pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool->Mutex);
+		--pool->Statistics.LiveIsolates;
+	}
+	pool->Release();
+}
+
+struct JSSnapshot : RefCounted
+{
+	std::vector<uint8_t> Data;
+};
+
+// A CPU profile or heap snapshot as JSON
+struct JSProfile : RefCounted
+{
+	std::string Data;
+};
+
+// The contents of an array buffer transferred by a serialized value, owned
+// by the value until it's deserialized
+struct TransferredBuffer
+{
+	void* Data;
+	size_t Length;
+};
+
+struct JSSerializedValue : RefCounted
+{
+	std::vector<uint8_t> Data;
+	// Guards Buffers, which the first deserialization takes
+	std::mutex Mutex;
+	std::vector<TransferredBuffer> Buffers;
+	ArrayBufferAllocator* Allocator;
+
+	JSSerializedValue()
+		: Allocator(nullptr)
+	{
+	}
+
+	~JSSerializedValue()
+	{
+		for (auto& buffer: Buffers)
+			Allocator->Free(buffer.Data, buffer.Length);
+		if (Allocator != nullptr)
+			Allocator->Release();
+	}
+};
+
+struct JSScript : RefCounted
+{
+	const ResettingPersistent<v8::UnboundScript> Handle;
+	// Produced when compiling without a cache
+	std::vector<uint8_t> CodeCache;
+	JSScript(v8::Isolate* isolate, const v8::Local<v8::UnboundScript>& handle)
+		: Handle(isolate, handle)
+	{
+	}
+	inline v8::Local<v8::UnboundScript> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+// A module loaded by require. The script stays compiled if running it
+// fails, so that requiring the module again only runs it again.
+struct JSModule
+{
+	JSScript* const Script;
+	// module, whose exports property is what require returns. Set while
+	// the module runs and after.
+	ResettingPersistent<v8::Object> Module;
+	JSModule(JSScript* script)
+		: Script(script)
+	{
+	}
+	~JSModule() { Script->Release(); }
+};
+
+void JSContext::ClearModules()
+{
+	for (auto& module : Modules)
+		delete module.second;
+	Modules.clear();
+}
+
+struct JSClass : RefCounted
+{
+	const ResettingPersistent<v8::FunctionTemplate> Handle;
+	// V8 doesn't allow changing a template once it has been instantiated
+	bool Instantiated;
+	JSClass(v8::Isolate* isolate, const v8::Local<v8::FunctionTemplate>& handle)
+		: Handle(isolate, handle)
+		, Instantiated(false)
+	{
+	}
+	inline v8::Local<v8::FunctionTemplate> LocalHandle(JSContext* context) { return Handle.Get(context->Isolate); }
+};
+
+// The native side of a JSClass instance, stored in its internal field.
+// Passes Data to the context's ExternalFinalizer when the instance is
+// garbage collected.
+struct JSClassInstanceData
+{
+	JSContext* Context;
+	ResettingPersistent<v8::Object> Handle;
+	void* Data;
+};
+
+static JSScriptException* NewScriptException(JSContext* context, const v8::TryCatch& tryCatch)
+{
+	// There's no exception object or message to report
+	if (tryCatch.HasTerminated())
+		return new JSScriptException(context, JSScriptExceptionKind::Terminated);
+
+	auto exception = new JSScriptException(context, JSScriptExceptionKind::Exception);
+	if (!tryCatch.Exception().IsEmpty())
+		exception->ExceptionHandle.Reset(context->Isolate, tryCatch.Exception());
+	auto message = tryCatch.Message();
+	if (!message.IsEmpty())
+		exception->MessageHandle.Reset(context->Isolate, message);
+	return exception;
+}
+
+// Reports the exception from inner, either thrown or left in the TryCatch.
+// Leaving it is cheaper, so the common calls that end in a call into script do
+// that through ToLocalOrCaught. An inner that returns with an exception caught
+// must return the default value of its type.
+template<typename Result>
+struct TryCatchResult
+{
+	template<typename T>
+	static Result Invoke(JSScriptException** outError, JSContext* context, v8::TryCatch& tryCatch, T& inner)
+	{
+		auto result = inner(tryCatch);
+		if (tryCatch.HasCaught())
+		{
+			*outError = NewScriptException(context, tryCatch);
+			return Result();
+		}
+		return result;
+	}
+};
+
+template<>
+struct TryCatchResult<void>
+{
+	template<typename T>
+	static void Invoke(JSScriptException** outError, JSContext* context, v8::TryCatch& tryCatch, T& inner)
+	{
+		inner(tryCatch);
+		if (tryCatch.HasCaught())
+			*outError = NewScriptException(context, tryCatch);
+	}
+};
+
+template<typename T>
+inline static auto TryCatch(
+	JSScriptException** outError,
+	JSContext* context,
+	T inner) -> decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr))
+{
+	typedef decltype(inner((v8::TryCatch&)*(v8::TryCatch*)nullptr)) Result;
+	V8Scope scope(context);
+	ExecutionScope executionScope(context);
+	*outError = nullptr;
+	try
+	{
+		v8::TryCatch tryCatch;
+		return TryCatchResult<Result>::Invoke(outError, context, tryCatch, inner);
+	}
+	catch (JSScriptException* exception)
+	{
+		*outError = exception;
+		return Result();
+	}
+}
+
+static void Throw(JSContext* context, const v8::TryCatch& tryCatch)
+{
+	throw NewScriptException(context, tryCatch);
+}
+
+// Like FromJust, but returns false and leaves the exception for TryCatch to
+// report instead of throwing it. Only for the last call in a TryCatch inner.
+template<class A>
+inline static bool ToLocalOrCaught(
+	JSContext* context,
+	const v8::TryCatch& tryCatch,
+	v8::MaybeLocal<A> a,
+	v8::Local<A>* out)
+{
+	if (!tryCatch.HasCaught() && a.ToLocal(out))
+		return true;
+	if (!tryCatch.HasCaught())
+		Throw(context, tryCatch);
+	return false;
+}
+
 template<class A>
 inline static v8::Local<A> FromJust(
 	JSContext* context,
-	const v8::TryCatch& tryCatch,
-	v8::MaybeLocal<A> a)
+	const v8::TryCatch& tryCatch,
+	v8::MaybeLocal<A> a)
+{
+	if (tryCatch.HasCaught() || a.IsEmpty())
+	{
+		Throw(context, tryCatch);
+	}
+	return a.ToLocalChecked();
+}
+
+template<class A>
+inline static A FromJust(
+	JSContext* context,
+	const v8::TryCatch& tryCatch,
+	v8::Maybe<A> a)
+{
+	if (tryCatch.HasCaught() || a.IsNothing())
+	{
+		Throw(context, tryCatch);
+	}
+	return a.FromJust();
+}
+
+// Returns the cached wrapper for handle, retained, if the context's identity
+// cache is enabled and has one. Otherwise creates a new wrapper and caches it.
+template<typename Wrapper, typename T>
+static Wrapper* NewCachedWrapper(JSContext* context, JSType type, v8::Local<T> handle)
+{
+	if (!context->IdentityCacheEnabled)
+		return new Wrapper(context->Isolate, handle);
+
+	auto hash = handle->GetIdentityHash();
+	auto range = context->IdentityCache.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		auto cached = it->second->Wrapper;
+		if (cached->Type() == type
+			&& static_cast<Wrapper*>(cached)->Handle == handle
+			&& cached->TryRetain())
+		{
+			return static_cast<Wrapper*>(cached);
+		}
+	}
+
+	auto wrapper = new Wrapper(context->Isolate, handle);
+	wrapper->CacheEntry.Context = context;
+	wrapper->CacheEntry.Wrapper = wrapper;
+	wrapper->CacheEntry.Hash = hash;
+	context->IdentityCache.emplace(hash, &wrapper->CacheEntry);
+	return wrapper;
+}
+
+// The type checks make the casts safe, so unlike conversions this can't throw
+static JSValue* Wrap(JSContext* context, v8::Local<v8::Value> value)
+{
+	CountCall(JSInstrumentedCall::Wrap);
+	if (value->IsUndefined() || value->IsNull())
+		return nullptr;
+	if (value->IsInt32())
+		return NewJSInt(value.As<v8::Int32>()->Value());
+	if (value->IsNumber())
+		return NewJSDouble(value.As<v8::Number>()->Value());
+	if (value->IsBoolean())
+		return NewJSBool(value.As<v8::Boolean>()->Value());
+	if (value->IsString())
+		return new JSString(context->Isolate, value.As<v8::String>());
+	if (value->IsArray())
+		return NewCachedWrapper<JSArray>(context, JSType::Array, value.As<v8::Array>());
+	if (value->IsFunction())
+		return NewCachedWrapper<JSFunction>(context, JSType::Function, value.As<v8::Function>());
+	if (value->IsExternal())
+		return new JSExternal(context->Isolate, value.As<v8::External>());
+	if (value->IsPromise())
+		return NewCachedWrapper<JSPromise>(context, JSType::Promise, value.As<v8::Promise>());
+	if (value->IsObject())
+		return NewCachedWrapper<JSObject>(context, JSType::Object, value.As<v8::Object>());
+	return nullptr; // TODO do something good here
+}
+
+static v8::Local<v8::Value> Unwrap(v8::Isolate* isolate, JSValue* value)
+{
+	CountCall(JSInstrumentedCall::Unwrap);
+	switch (GetJSValueType(value))
+	{
+		case JSType::Null:
+			return v8::Null(isolate).As<v8::Value>();
+		case JSType::Int:
+			return v8::Int32::New(isolate, IntValue(value));
+		case JSType::Double:
+			return v8::Number::New(isolate, DoubleValue(value));
+		case JSType::Bool:
+			return v8::Boolean::New(isolate, BoolValue(value));
+		case JSType::String:
+			return static_cast<JSString*>(value)->LocalHandle(isolate);
+		case JSType::Array:
+			return static_cast<JSArray*>(value)->LocalHandle(isolate);
+		case JSType::Function:
+			return static_cast<JSFunction*>(value)->LocalHandle(isolate);
+		case JSType::External:
+			return static_cast<JSExternal*>(value)->LocalHandle(isolate);
+		case JSType::Object:
+		case JSType::Promise:
+			return static_cast<JSObject*>(value)->LocalHandle(isolate);
+		default: break;
+	}
+	return v8::Null(isolate).As<v8::Value>(); // TODO do something good here
+}
+
+// Sets immediates directly, so returning numbers doesn't allocate a handle
+static void SetReturnValue(const v8::FunctionCallbackInfo<v8::Value>& info, JSValue* result)
+{
+	switch (ImmediateTag(result))
+	{
+		case ImmediateIntTag:
+			info.GetReturnValue().Set(static_cast<int32_t>(IntValue(result)));
+			break;
+		case ImmediateBoolTag:
+			info.GetReturnValue().Set(BoolValue(result));
+			break;
+		case ImmediateDoubleTag:
+			info.GetReturnValue().Set(DoubleValue(result));
+			break;
+		default:
+			if (result == nullptr)
+				info.GetReturnValue().SetNull();
+			else
+				info.GetReturnValue().Set(Unwrap(info.GetIsolate(), result));
+			break;
+	}
+}
+
+static inline JSValue* WrapMaybe(JSContext* context, const v8::TryCatch& tryCatch, v8::MaybeLocal<v8::Value> value)
+{
+	return Wrap(context, FromJust(context, tryCatch, value));
+}
+
+// WrapMaybe for the result of a TryCatch inner, see ToLocalOrCaught
+static inline JSValue* WrapResult(JSContext* context, const v8::TryCatch& tryCatch, v8::MaybeLocal<v8::Value> value)
+{
+	v8::Local<v8::Value> local;
+	if (!ToLocalOrCaught(context, tryCatch, value, &local))
+		return nullptr;
+	return Wrap(context, local);
+}
+
+template<typename T>
+inline static T const* data_ptr(const std::vector<T>& v)
+{
+	return v.size() > 0
+		? &*v.begin()
+		: nullptr;
+}
+
+template<typename T>
+inline static T* data_ptr(std::vector<T>& v)
+{
+	return v.size() > 0
+		? &*v.begin()
+		: nullptr;
+}
+
+// Callbacks with up to this many arguments wrap them on the stack
+static const int FastCallbackStackArgs = 8;
+
+// Calls callback with the wrapped arguments, preceded by the receiver if
+// passThis is set, and hands its result or error back to V8
+static void InvokeFastCallback(
+	const v8::FunctionCallbackInfo<v8::Value>& info,
+	JSContext* context,
+	void* data,
+	JSFastCallback callback,
+	bool passThis)
+{
+	InstrumentedCall instrumented(JSInstrumentedCall::FastCallback, "JSFastCallback");
+	auto isolate = info.GetIsolate();
+	auto offset = passThis ? 1 : 0;
+	auto numArgs = info.Length() + offset;
+	JSValue* stackArgs[FastCallbackStackArgs];
+	std::vector<JSValue*> heapArgs;
+	JSValue** args = stackArgs;
+	if (numArgs > FastCallbackStackArgs)
+	{
+		heapArgs.resize(numArgs);
+		args = data_ptr(heapArgs);
+	}
+	if (passThis)
+		args[0] = Wrap(context, info.This());
+	for (int i = offset; i < numArgs; ++i)
+		args[i] = Wrap(context, info[i - offset]);
+
+	JSValue* error = nullptr;
+	JSValue* result = callback(context, data, args, numArgs, &error);
+
+	for (int i = 0; i < numArgs; ++i)
+		ReleaseValue(args[i]);
+
+	SetReturnValue(info, result);
+	ReleaseValue(result);
+
+	if (error != nullptr)
+	{
+		auto unwrappedError = Unwrap(isolate, error);
+		ReleaseValue(error);
+		isolate->ThrowException(unwrappedError);
+	}
+}
+
+// A call queued on a context's executor
+struct JSAsyncTask
+{
+	JSAsyncTask* Next;
+	JSAsyncResult* const Result;
+	void* const Data;
+	const JSAsyncCallback Callback;
+	// Makes the call. Run with the isolate locked.
+	const std::function<JSValue*(JSScriptException**)> Call;
+	// Releases what Call holds on to, whether or not it ran
+	const std::function<void()> Dispose;
+};
+
+struct JSAsyncResult : RefCounted
+{
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::atomic<bool> Done;
+	JSValue* Value;
+	JSScriptException* Error;
+
+	JSAsyncResult()
+		: Done(false)
+		, Value(nullptr)
+		, Error(nullptr)
+	{
+	}
+
+	// Requires the isolate lock, see ReleaseJSAsyncResult
+	virtual ~JSAsyncResult() override
+	{
+		ReleaseValue(Value);
+		if (Error != nullptr)
+			Error->Release();
+	}
+
+	void Complete(JSValue* value, JSScriptException* error)
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Value = value;
+			Error = error;
+			Done = true;
+		}
+		Condition.notify_all();
+	}
+};
+
+// Runs the calls submitted to a context on a thread of its own. Submitting
+// pushes onto a lock-free stack, which the thread takes over as a whole and
+// runs in submission order while holding the isolate lock once.
+struct JSExecutor
+{
+	JSContext* const Context;
+	std::atomic<JSAsyncTask*> Pending;
+	// Set while the thread waits, so that Submit only locks Mutex to wake it
+	std::atomic<bool> Waiting;
+	std::atomic<bool> Stopping;
+	std::mutex Mutex;
+	std::condition_variable Condition;
+	std::thread Thread;
+
+	JSExecutor(JSContext* context)
+		: Context(context)
+		, Pending(nullptr)
+		, Waiting(false)
+		, Stopping(false)
+		, Thread([this] { Run(); })
+	{
+	}
+
+	~JSExecutor()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Stopping = true;
+		}
+		Condition.notify_one();
+		Thread.join();
+
+		auto tasks = Pending.exchange(nullptr);
+		if (tasks != nullptr)
+		{
+			IsolateEntry entry(Context->Isolate);
+			Drop(tasks);
+		}
+	}
+
+	void Submit(JSAsyncTask* task)
+	{
+		task->Next = Pending.load();
+		while (!Pending.compare_exchange_weak(task->Next, task))
+		{
+		}
+		if (Waiting)
+		{
+			std::lock_guard<std::mutex> lock(Mutex);
+			Condition.notify_one();
+		}
+	}
+
+	// Waits for submitted tasks and returns them oldest first, or null when
+	// stopping
+	JSAsyncTask* Take()
+	{
+		for (;;)
+		{
+			if (auto tasks = Pending.exchange(nullptr))
+			{
+				JSAsyncTask* reversed = nullptr;
+				while (tasks != nullptr)
+				{
+					auto next = tasks->Next;
+					tasks->Next = reversed;
+					reversed = tasks;
+					tasks = next;
+				}
+				return reversed;
+			}
+
+			std::unique_lock<std::mutex> lock(Mutex);
+			if (Stopping)
+				return nullptr;
+			Waiting = true;
+			Condition.wait(lock, [this] { return Stopping || Pending.load() != nullptr; });
+			Waiting = false;
+		}
+	}
+
+	void Run()
+	{
+		while (auto tasks = Take())
+		{
+			IsolateEntry entry(Context->Isolate);
+			while (tasks != nullptr && !Stopping)
+			{
+				auto task = tasks;
+				tasks = task->Next;
+
+				JSScriptException* error = nullptr;
+				auto value = task->Call(&error);
+				task->Dispose();
+				task->Result->Complete(value, error);
+				if (task->Callback != nullptr)
+					task->Callback(Context, task->Data, task->Result);
+				task->Result->Release();
+				delete task;
+			}
+			Drop(tasks);
+		}
+	}
+
+	// Releases tasks that won't run. Requires the isolate lock.
+	void Drop(JSAsyncTask* tasks)
+	{
+		while (tasks != nullptr)
+		{
+			auto task = tasks;
+			tasks = task->Next;
+			task->Dispose();
+			task->Result->Complete(nullptr, nullptr);
+			if (Context->ExternalFinalizer != nullptr && task->Data != nullptr)
+				Context->ExternalFinalizer(task->Data);
+			task->Result->Release();
+			delete task;
+		}
+	}
+};
+
+static void DeleteExecutor(JSExecutor* executor)
+{
+	delete executor;
+}
+
+// Queues call on the context's executor, which mustn't be null, and returns
+// its result
+static JSAsyncResult* SubmitAsync(
+	JSContext* context,
+	void* data,
+	JSAsyncCallback callback,
+	std::function<JSValue*(JSScriptException**)> call,
+	std::function<void()> dispose)
 {
-	if (tryCatch.HasCaught() || a.IsEmpty())
+	auto result = new JSAsyncResult();
+	// One reference for the caller and one for the task
+	result->Retain();
+	context->Executor->Submit(new JSAsyncTask{nullptr, result, data, callback, std::move(call), std::move(dispose)});
+	return result;
+}
+
+// Releases object from any thread. Only the last reference needs the
+// isolate lock, and while another thread holds it that reference is left
+// for the holder to release rather than waited for.
+static void ReleaseFromAnyThread(JSContext* context, RefCounted* object)
+{
+	if (object->ReleaseUnlessLast())
+		return;
+	if (!v8::Locker::IsLocked(context->Isolate) && context->LockHolders.load() > 0)
 	{
-		Throw(context, tryCatch);
+		context->DeferRelease(object);
+		// Holders stop counting before their last drain, so if none are
+		// left the deferred release may have been missed
+		if (context->LockHolders.load() > 0)
+			return;
+		IsolateEntry entry(context->Isolate);
+		context->DrainReleases();
+		return;
 	}
-	return a.ToLocalChecked();
+	IsolateEntry entry(context->Isolate);
+	object->Release();
 }
 
-template<class A>
-inline static A FromJust(
-	JSContext* context,
-	const v8::TryCatch& tryCatch,
-	v8::Maybe<A> a)
+// -------------------------------------------------------------------------
+// Context
+DllPublic bool CDecl InitializeJSPlatform(int threadCount, const char* flags)
 {
-	if (tryCatch.HasCaught() || a.IsNothing())
+	return InitializeV8(threadCount, flags);
+}
+
+DllPublic void CDecl RetainJSContext(JSContext* context)
+{
+	if (context != nullptr)
 	{
-		Throw(context, tryCatch);
+		context->Retain();
 	}
-	return a.FromJust();
 }
 
-static JSValue* Wrap(JSContext* context, const v8::TryCatch& tryCatch, v8::Local<v8::Value> value)
+DllPublic void CDecl ReleaseJSContext(JSContext* context)
 {
-	if (value->IsUndefined() || value->IsNull())
+	// Only the last reference waits for other threads to be done with the
+	// isolate, which the destructor locks while resetting its handles
+	if (context != nullptr && !context->ReleaseUnlessLast())
+		context->Release();
+}
+
+DllPublic JSContext* CDecl CreateJSContext(
+	JSCallbackFinalizer callbackFinalizer,
+	JSExternalFinalizer externalFinalizer)
+{
+	return new JSContext(callbackFinalizer, externalFinalizer);
+}
+
+DllPublic JSContext* CDecl CreateJSContextFromSnapshot(
+	JSCallbackFinalizer callbackFinalizer,
+	JSExternalFinalizer externalFinalizer,
+	const uint8_t* snapshotData,
+	int snapshotLength)
+{
+	return new JSContext(callbackFinalizer, externalFinalizer, snapshotData, snapshotLength);
+}
+
+DllPublic JSContext* CDecl CreateJSContextWithOptions(
+	JSCallbackFinalizer callbackFinalizer,
+	JSExternalFinalizer externalFinalizer,
+	const JSContextOptions* options)
+{
+	auto context = new JSContext(callbackFinalizer, externalFinalizer, nullptr, 0, options);
+	IsolateEntry entry(context->Isolate);
+	if (context->OOMErrorHandler != nullptr)
+	{
+		// The callback has no data, but runs on the thread that has the
+		// isolate entered
+		context->Isolate->SetOOMErrorHandler([] (const char* location, bool isHeapOOM)
+		{
+			auto context = static_cast<JSContext*>(v8::Isolate::GetCurrent()->GetData(0));
+			context->OOMErrorHandler(location, isHeapOOM);
+		});
+	}
+	UpdateGCCallbacks(context);
+	return context;
+}
+
+DllPublic int CDecl PumpJSContextMessageLoop(JSContext* context, int maxTasks)
+{
+	IsolateEntry entry(context->Isolate);
+	int count = 0;
+	while ((maxTasks <= 0 || count < maxTasks) && v8::platform::PumpMessageLoop(_platform, context->Isolate))
+		++count;
+	return count;
+}
+
+DllPublic void CDecl SetJSMicrotasksPolicy(JSContext* context, JSMicrotasksPolicy policy)
+{
+	IsolateEntry entry(context->Isolate);
+	context->Isolate->SetMicrotasksPolicy(policy == JSMicrotasksPolicy::Explicit
+		? v8::MicrotasksPolicy::kExplicit
+		: v8::MicrotasksPolicy::kAuto);
+}
+
+DllPublic void CDecl RunJSMicrotasks(JSContext* context)
+{
+	V8Scope scope(context);
+	context->Isolate->RunMicrotasks();
+}
+
+DllPublic void CDecl EnqueueJSMicrotask(JSContext* context, JSFunction* microtask)
+{
+	V8Scope scope(context);
+	context->Isolate->EnqueueMicrotask(microtask->LocalHandle(context));
+}
+
+DllPublic JSValue* CDecl JSContextEvaluateCreate(JSContext* context, JSString* fileName, JSString* code, JSScriptException** outError)
+{
+	InstrumentedCall instrumented(JSInstrumentedCall::Evaluate, "JSContextEvaluateCreate");
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		v8::ScriptOrigin origin(fileName->LocalHandle(context));
+		v8::Local<v8::Script> script;
+		if (!ToLocalOrCaught(
+			context,
+			tryCatch,
+			v8::Script::Compile(
+				context->LocalHandle(),
+				code->LocalHandle(context),
+				&origin),
+			&script))
+		{
+			return static_cast<JSValue*>(nullptr);
+		}
+
+		return WrapResult(context, tryCatch, script->Run(context->LocalHandle()));
+	});
+}
+
+DllPublic void CDecl BeginJSContextSession(JSContext* context)
+{
+	auto isolate = context->Isolate;
+	if (v8::Locker::IsLocked(isolate) && context->Session != nullptr)
+	{
+		++context->Session->Depth;
+		return;
+	}
+	// Blocks until other threads are done with the isolate
+	++context->LockHolders;
+	auto session = new JSContextSession(isolate);
+	context->Session = session;
+	context->SetThreadStackLimit();
+}
+
+DllPublic void CDecl EndJSContextSession(JSContext* context)
+{
+	if (!v8::Locker::IsLocked(context->Isolate) || context->Session == nullptr)
+		return; // No session on this thread
+	auto session = context->Session;
+	if (--session->Depth == 0)
+	{
+		--context->LockHolders;
+		context->DrainReleases();
+		context->Session = nullptr;
+		delete session;
+	}
+}
+
+DllPublic int CDecl DrainJSContextReleases(JSContext* context)
+{
+	IsolateEntry entry(context->Isolate);
+	return context->DrainReleases();
+}
+
+DllPublic void CDecl SetJSContextIdentityCacheEnabled(JSContext* context, bool enabled)
+{
+	IsolateEntry entry(context->Isolate);
+	if (!enabled)
+		context->ClearIdentityCache();
+	context->IdentityCacheEnabled = enabled;
+}
+
+DllPublic void CDecl SetJSContextTimeout(JSContext* context, int milliseconds)
+{
+	IsolateEntry entry(context->Isolate);
+	if (milliseconds > 0 && context->Watchdog == nullptr)
+		context->Watchdog = new JSWatchdog(context->Isolate);
+	context->Timeout = milliseconds > 0 ? milliseconds : 0;
+}
+
+DllPublic void CDecl TerminateJSExecution(JSContext* context)
+{
+	// Terminating with nothing running would terminate the next call instead
+	std::lock_guard<std::mutex> lock(context->TerminationMutex);
+	if (context->ExecutionDepth > 0)
+	{
+		context->TerminationRequested = true;
+		context->Isolate->TerminateExecution();
+	}
+}
+
+DllPublic bool CDecl IsJSExecutionTerminating(JSContext* context)
+{
+	return context->Isolate->IsExecutionTerminating();
+}
+
+DllPublic void CDecl CancelJSTerminateExecution(JSContext* context)
+{
+	context->Isolate->CancelTerminateExecution();
+}
+
+DllPublic void CDecl RequestJSInterrupt(JSContext* context, void* data, JSInterruptCallback callback)
+{
+	struct Interrupt
+	{
+		JSContext* context;
+		void* data;
+		JSInterruptCallback callback;
+	};
+	context->Isolate->RequestInterrupt(
+		[] (v8::Isolate* isolate, void* data)
+		{
+			auto interrupt = static_cast<Interrupt*>(data);
+			interrupt->callback(interrupt->context, interrupt->data);
+			delete interrupt;
+		},
+		new Interrupt{context, data, callback});
+}
+
+DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context)
+{
+	V8Scope scope(context);
+	return NewCachedWrapper<JSObject>(context, JSType::Object, context->LocalHandle()->Global());
+}
+
+DllPublic const char* CDecl GetV8Version() { return v8::V8::GetVersion(); }
+
+// -------------------------------------------------------------------------
+// Async
+DllPublic bool CDecl StartJSContextExecutor(JSContext* context)
+{
+	if (context->Executor != nullptr || context->OwnerLocker != nullptr)
+		return false;
+	context->Executor = new JSExecutor(context);
+	return true;
+}
+
+DllPublic void CDecl RetainJSAsyncResult(JSAsyncResult* result)
+{
+	if (result != nullptr)
+		result->Retain();
+}
+
+DllPublic void CDecl ReleaseJSAsyncResult(JSContext* context, JSAsyncResult* result)
+{
+	if (result != nullptr)
+	{
+		// Releases the result's value and error
+		ReleaseFromAnyThread(context, result);
+	}
+}
+
+DllPublic JSAsyncResult* CDecl JSContextEvaluateAsync(JSContext* context, JSString* fileName, JSString* code, void* data, JSAsyncCallback callback)
+{
+	if (context->Executor == nullptr)
 		return nullptr;
-	if (value->IsInt32())
-		return new JSInt(FromJust(context, tryCatch, value->Int32Value(context->LocalHandle())));
-	if (value->IsNumber())
-		return new JSDouble(FromJust(context, tryCatch, value->NumberValue(context->LocalHandle())));
-	if (value->IsBoolean())
-		return new JSBool(FromJust(context, tryCatch, value->BooleanValue(context->LocalHandle())));
-	if (value->IsString())
-		return new JSString(context->Isolate, FromJust(context, tryCatch, value->ToString(context->LocalHandle())));
-	if (value->IsArray())
-		return new JSArray(context->Isolate, FromJust(context, tryCatch, value->ToObject(context->LocalHandle())).As<v8::Array>());
-	if (value->IsFunction())
-		return new JSFunction(context->Isolate, FromJust(context, tryCatch, value->ToObject(context->LocalHandle())).As<v8::Function>());
-	if (value->IsExternal())
-		return new JSExternal(context->Isolate, value.As<v8::External>());
-	if (value->IsObject())
-		return new JSObject(context->Isolate, FromJust(context, tryCatch, value->ToObject(context->LocalHandle())));
-	return nullptr; // TODO do something good here
+	RetainValue(fileName);
+	RetainValue(code);
+	return SubmitAsync(
+		context,
+		data,
+		callback,
+		[=] (JSScriptException** outError)
+		{
+			return JSContextEvaluateCreate(context, fileName, code, outError);
+		},
+		[=] ()
+		{
+			ReleaseValue(code);
+			ReleaseValue(fileName);
+		});
+}
+
+DllPublic JSAsyncResult* CDecl CallJSFunctionAsync(JSContext* context, JSFunction* function, JSObject* thisObject, JSValue* const* args, int numArgs, void* data, JSAsyncCallback callback)
+{
+	if (context->Executor == nullptr)
+		return nullptr;
+	RetainValue(function);
+	RetainValue(thisObject);
+	auto retainedArgs = std::make_shared<std::vector<JSValue*>>(args, args + numArgs);
+	for (auto arg: *retainedArgs)
+		RetainValue(arg);
+	return SubmitAsync(
+		context,
+		data,
+		callback,
+		[=] (JSScriptException** outError)
+		{
+			return CallJSFunctionCreate(context, function, thisObject, data_ptr(*retainedArgs), numArgs, outError);
+		},
+		[=] ()
+		{
+			for (auto arg: *retainedArgs)
+				ReleaseValue(arg);
+			ReleaseValue(thisObject);
+			ReleaseValue(function);
+		});
+}
+
+DllPublic bool CDecl IsJSAsyncResultDone(JSAsyncResult* result)
+{
+	return result->Done;
+}
+
+DllPublic bool CDecl WaitJSAsyncResult(JSAsyncResult* result, int timeoutMilliseconds)
+{
+	std::unique_lock<std::mutex> lock(result->Mutex);
+	auto done = [result] { return result->Done.load(); };
+	if (timeoutMilliseconds < 0)
+	{
+		result->Condition.wait(lock, done);
+		return true;
+	}
+	return result->Condition.wait_for(lock, std::chrono::milliseconds(timeoutMilliseconds), done);
+}
+
+DllPublic JSValue* CDecl CopyJSAsyncResultValue(JSAsyncResult* result)
+{
+	std::lock_guard<std::mutex> lock(result->Mutex);
+	RetainValue(result->Value);
+	return result->Value;
+}
+
+DllPublic JSScriptException* CDecl CopyJSAsyncResultError(JSAsyncResult* result)
+{
+	std::lock_guard<std::mutex> lock(result->Mutex);
+	if (result->Error != nullptr)
+		result->Error->Retain();
+	return result->Error;
+}
+
+// -------------------------------------------------------------------------
+// Context pool
+DllPublic void CDecl RetainJSContextPool(JSContextPool* pool)
+{
+	if (pool != nullptr)
+		pool->Retain();
+}
+
+DllPublic void CDecl ReleaseJSContextPool(JSContextPool* pool)
+{
+	if (pool != nullptr)
+		pool->Release();
+}
+
+DllPublic JSContextPool* CDecl CreateJSContextPool(
+	int maxIdleContexts,
+	bool resetContexts,
+	JSCallbackFinalizer callbackFinalizer,
+	JSExternalFinalizer externalFinalizer)
+{
+	return new JSContextPool(maxIdleContexts, resetContexts, callbackFinalizer, externalFinalizer);
+}
+
+DllPublic JSContext* CDecl AcquireJSContext(JSContextPool* pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool->Mutex);
+		if (!pool->IdleContexts.empty())
+		{
+			auto context = pool->IdleContexts.back();
+			pool->IdleContexts.pop_back();
+			++pool->Statistics.Hits;
+			--pool->Statistics.IdleIsolates;
+			pool->Retain();
+			return context;
+		}
+		++pool->Statistics.Misses;
+		++pool->Statistics.LiveIsolates;
+	}
+	auto context = new JSContext(pool->CallbackFinalizer, pool->ExternalFinalizer);
+	pool->Retain();
+	context->Pool = pool;
+	return context;
+}
+
+DllPublic void CDecl ReleaseJSContextToPool(JSContextPool* pool, JSContext* context)
+{
+	if (context == nullptr)
+		return;
+
+	// Contexts that are still referenced elsewhere, or that come from
+	// somewhere else, are just released.
+	if (context->Pool != pool || context->_refCount != 1)
+	{
+		ReleaseJSContext(context);
+		return;
+	}
+
+	// Its queued calls would otherwise run against the next user's context
+	DeleteExecutor(context->Executor);
+	context->Executor = nullptr;
+	SetJSDebugMessageHandler(context, nullptr, nullptr);
+	SetJSContextIdentityCacheEnabled(context, false);
+	SetJSGCEventHandler(context, nullptr, nullptr);
+	SetJSModuleLoader(context, nullptr, nullptr, nullptr);
+	SetJSContextTimeout(context, 0);
+	SetJSMicrotasksPolicy(context, JSMicrotasksPolicy::Auto);
+	if (pool->ResetContexts)
+	{
+		IsolateEntry entry(context->Isolate);
+		v8::HandleScope handleScope(context->Isolate);
+		context->Handle.Reset(context->Isolate, context->NewLocalContext());
+		context->Isolate->ContextDisposedNotification();
+	}
+
+	// Checked and pushed under one lock so that concurrent releases can't
+	// go past MaxIdleContexts
+	bool recycled = false;
+	{
+		std::lock_guard<std::mutex> lock(pool->Mutex);
+		if (static_cast<int>(pool->IdleContexts.size()) < pool->MaxIdleContexts)
+		{
+			pool->IdleContexts.push_back(context);
+			++pool->Statistics.IdleIsolates;
+			recycled = true;
+		}
+	}
+	if (recycled)
+		pool->Release(); // The context's reference, see JSContext::Pool
+	else
+		ReleaseJSContext(context);
+}
+
+DllPublic void CDecl GetJSContextPoolStatistics(JSContextPool* pool, JSContextPoolStatistics* outStatistics)
+{
+	std::lock_guard<std::mutex> lock(pool->Mutex);
+	*outStatistics = pool->Statistics;
+}
+
+// -------------------------------------------------------------------------
+// Snapshot
+DllPublic void CDecl RetainJSSnapshot(JSSnapshot* snapshot)
+{
+	if (snapshot != nullptr)
+		snapshot->Retain();
+}
+
+DllPublic void CDecl ReleaseJSSnapshot(JSSnapshot* snapshot)
+{
+	if (snapshot != nullptr)
+		snapshot->Release();
+}
+
+DllPublic JSSnapshot* CDecl CreateJSSnapshot(const uint16_t* const* sources, const int* sourceLengths, int numSources, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	InitializeV8();
+
+	// Creates and enters its own isolate
+	v8::SnapshotCreator snapshotCreator;
+	auto isolate = snapshotCreator.GetIsolate();
+	{
+		v8::HandleScope handleScope(isolate);
+		auto localContext = v8::Context::New(isolate);
+		v8::Context::Scope contextScope(localContext);
+		v8::TryCatch tryCatch(isolate);
+
+		for (int i = 0; i < numSources && *outError == JSRuntimeError::NoError; ++i)
+		{
+			v8::Local<v8::String> source;
+			v8::Local<v8::Script> script;
+			if (!v8::String::NewFromTwoByte(isolate, sources[i], v8::NewStringType::kNormal, sourceLengths[i]).ToLocal(&source))
+				*outError = JSRuntimeError::StringTooLong;
+			else if (!v8::Script::Compile(localContext, source).ToLocal(&script) || script->Run(localContext).IsEmpty())
+				*outError = JSRuntimeError::ScriptError;
+		}
+		snapshotCreator.AddContext(localContext);
+	}
+
+	// Must be called outside of any HandleScope
+	auto blob = snapshotCreator.CreateBlob(v8::SnapshotCreator::FunctionCodeHandling::kClear);
+	JSSnapshot* snapshot = nullptr;
+	if (*outError == JSRuntimeError::NoError)
+	{
+		if (blob.data == nullptr)
+		{
+			*outError = JSRuntimeError::ScriptError;
+		}
+		else
+		{
+			snapshot = new JSSnapshot();
+			snapshot->Data.assign(blob.data, blob.data + blob.raw_size);
+		}
+	}
+	delete[] blob.data;
+	return snapshot;
+}
+
+DllPublic int CDecl CopyJSSnapshotData(JSSnapshot* snapshot, uint8_t* outBuffer, int bufferLength)
+{
+	auto length = static_cast<int>(snapshot->Data.size());
+	if (outBuffer != nullptr && length > 0 && bufferLength >= length)
+		memcpy(outBuffer, data_ptr(snapshot->Data), length);
+	return length;
 }
 
-static v8::Local<v8::Value> Unwrap(v8::Isolate* isolate, JSValue* value)
-{
-	switch (GetJSValueType(value))
+// -------------------------------------------------------------------------
+// Script
+DllPublic void CDecl RetainJSScript(JSContext* context, JSScript* script)
+{
+	if (script != nullptr)
+		script->Retain();
+}
+
+DllPublic void CDecl ReleaseJSScript(JSContext* context, JSScript* script)
+{
+	if (script != nullptr)
+	{
+		// Resets the script's handle
+		ReleaseFromAnyThread(context, script);
+	}
+}
+
+// Compiles code, consuming cacheData if there is any, and producing a code
+// cache for CopyJSScriptCodeCache otherwise. Returns null, with an exception
+// pending in V8, if the code doesn't compile.
+static JSScript* CompileScript(
+	JSContext* context,
+	v8::Local<v8::String> fileName,
+	v8::Local<v8::String> code,
+	const uint8_t* cacheData,
+	int cacheLength,
+	bool* outCacheRejected)
+{
+	*outCacheRejected = false;
+	bool consumeCache = cacheData != nullptr && cacheLength > 0;
+	v8::ScriptOrigin origin(fileName);
+	// Source takes ownership of the CachedData, but not of its buffer
+	v8::ScriptCompiler::Source source(
+		code,
+		origin,
+		consumeCache ? new v8::ScriptCompiler::CachedData(cacheData, cacheLength) : nullptr);
+
+	v8::Local<v8::UnboundScript> unboundScript;
+	if (!v8::ScriptCompiler::CompileUnboundScript(
+			context->Isolate,
+			&source,
+			consumeCache
+				? v8::ScriptCompiler::kConsumeCodeCache
+				: v8::ScriptCompiler::kProduceCodeCache).ToLocal(&unboundScript))
+	{
+		return nullptr;
+	}
+	auto script = new JSScript(context->Isolate, unboundScript);
+
+	auto cachedData = source.GetCachedData();
+	if (consumeCache)
 	{
-		case JSType::Null:
-			return v8::Null(isolate).As<v8::Value>();
-		case JSType::Int:
-			return v8::Int32::New(isolate, static_cast<JSInt*>(value)->Value);
-		case JSType::Double:
-			return v8::Number::New(isolate, static_cast<JSDouble*>(value)->Value);
-		case JSType::Bool:
-			return v8::Boolean::New(isolate, static_cast<JSBool*>(value)->Value);
-		case JSType::String:
-			return static_cast<JSString*>(value)->LocalHandle(isolate);
-		case JSType::Array:
-			return static_cast<JSArray*>(value)->LocalHandle(isolate);
-		case JSType::Function:
-			return static_cast<JSFunction*>(value)->LocalHandle(isolate);
-		case JSType::External:
-			return static_cast<JSExternal*>(value)->LocalHandle(isolate);
-		case JSType::Object:
-			return static_cast<JSObject*>(value)->LocalHandle(isolate);
-		default: break;
+		*outCacheRejected = cachedData->rejected;
 	}
-	return v8::Null(isolate).As<v8::Value>(); // TODO do something good here
+	else if (cachedData != nullptr && cachedData->data != nullptr)
+	{
+		script->CodeCache.assign(cachedData->data, cachedData->data + cachedData->length);
+	}
+	return script;
 }
 
-static inline JSValue* WrapMaybe(JSContext* context, const v8::TryCatch& tryCatch, v8::MaybeLocal<v8::Value> value)
+DllPublic JSScript* CDecl CompileJSScript(JSContext* context, JSString* fileName, JSString* code, const uint8_t* cacheData, int cacheLength, bool* outCacheRejected, JSScriptException** outError)
 {
-	return Wrap(context, tryCatch, FromJust(context, tryCatch, value));
+	*outCacheRejected = false;
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return CompileScript(
+			context,
+			fileName->LocalHandle(context),
+			code->LocalHandle(context),
+			cacheData,
+			cacheLength,
+			outCacheRejected);
+	});
 }
 
-template<typename T>
-inline static T const* data_ptr(const std::vector<T>& v)
+DllPublic JSValue* CDecl RunJSScript(JSContext* context, JSScript* script, JSScriptException** outError)
 {
-	return v.size() > 0
-		? &*v.begin()
-		: nullptr;
+	InstrumentedCall instrumented(JSInstrumentedCall::RunScript, "RunJSScript");
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WrapResult(
+			context,
+			tryCatch,
+			script->LocalHandle(context)->BindToCurrentContext()->Run(context->LocalHandle()));
+	});
 }
 
-template<typename T>
-inline static T* data_ptr(std::vector<T>& v)
+DllPublic int CDecl CopyJSScriptCodeCache(JSScript* script, uint8_t* outBuffer, int bufferLength)
 {
-	return v.size() > 0
-		? &*v.begin()
-		: nullptr;
+	auto length = static_cast<int>(script->CodeCache.size());
+	if (outBuffer != nullptr && length > 0 && bufferLength >= length)
+		memcpy(outBuffer, data_ptr(script->CodeCache), length);
+	return length;
 }
 
 // -------------------------------------------------------------------------
-// Context
-DllPublic void CDecl RetainJSContext(JSContext* context)
+// Class
+DllPublic void CDecl RetainJSClass(JSContext* context, JSClass* cls)
 {
-	if (context != nullptr)
+	if (cls != nullptr)
+		cls->Retain();
+}
+
+DllPublic void CDecl ReleaseJSClass(JSContext* context, JSClass* cls)
+{
+	if (cls != nullptr)
 	{
-		context->Retain();
+		// Resets the class's templates
+		ReleaseFromAnyThread(context, cls);
 	}
 }
 
-DllPublic void CDecl ReleaseJSContext(JSContext* context)
+DllPublic JSClass* CDecl CreateJSClass(JSContext* context, JSString* name)
 {
-	if (context != nullptr)
+	V8Scope scope(context);
+	auto localClass = v8::FunctionTemplate::New(
+		context->Isolate,
+		[] (const v8::FunctionCallbackInfo<v8::Value>& info)
+		{
+			// Instances only come from CreateJSClassInstance, so that they
+			// always have their internal field set
+			auto isolate = info.GetIsolate();
+			isolate->ThrowException(v8::Exception::TypeError(
+				v8::String::NewFromUtf8(isolate, "Illegal constructor", v8::NewStringType::kNormal).ToLocalChecked()));
+		});
+	localClass->SetClassName(name->LocalHandle(context));
+	localClass->InstanceTemplate()->SetInternalFieldCount(1);
+	return new JSClass(context->Isolate, localClass);
+}
+
+// Returns a template for a function that can only be called on instances of
+// cls, and that calls callback with the instance as the first argument.
+static v8::Local<v8::FunctionTemplate> NewClassCallbackTemplate(
+	JSContext* context,
+	v8::Local<v8::FunctionTemplate> cls,
+	void* data,
+	JSCallback callback)
+{
+	auto classCallback = new JSClassCallback{context, data, callback};
+	context->ClassCallbacks.push_back(classCallback);
+	return v8::FunctionTemplate::New(
+		context->Isolate,
+		[] (const v8::FunctionCallbackInfo<v8::Value>& info)
+		{
+			v8::HandleScope handleScope(info.GetIsolate());
+			auto classCallback = static_cast<JSClassCallback*>(info.Data().As<v8::External>()->Value());
+			InvokeFastCallback(info, classCallback->Context, classCallback->Data, classCallback->Callback, true);
+		},
+		v8::External::New(context->Isolate, classCallback),
+		v8::Signature::New(context->Isolate, cls));
+}
+
+DllPublic void CDecl AddJSClassMethod(JSContext* context, JSClass* cls, JSString* name, void* data, JSCallback callback, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (cls->Instantiated)
 	{
-		v8::Locker(context->Isolate);
-		context->Release();
+		*outError = JSRuntimeError::TypeError;
+		return;
 	}
+	V8Scope scope(context);
+	auto localClass = cls->LocalHandle(context);
+	localClass->PrototypeTemplate()->Set(
+		name->LocalHandle(context),
+		NewClassCallbackTemplate(context, localClass, data, callback));
 }
 
-DllPublic JSContext* CDecl CreateJSContext(
-	JSCallbackFinalizer callbackFinalizer,
-	JSExternalFinalizer externalFinalizer)
+DllPublic void CDecl AddJSClassAccessor(JSContext* context, JSClass* cls, JSString* name, void* getterData, JSCallback getter, void* setterData, JSCallback setter, JSRuntimeError* outError)
 {
-	return new JSContext(callbackFinalizer, externalFinalizer);
+	*outError = JSRuntimeError::NoError;
+	if (cls->Instantiated)
+	{
+		*outError = JSRuntimeError::TypeError;
+		return;
+	}
+	V8Scope scope(context);
+	auto localClass = cls->LocalHandle(context);
+	localClass->PrototypeTemplate()->SetAccessorProperty(
+		name->LocalHandle(context),
+		NewClassCallbackTemplate(context, localClass, getterData, getter),
+		setter == nullptr
+			? v8::Local<v8::FunctionTemplate>()
+			: NewClassCallbackTemplate(context, localClass, setterData, setter));
 }
 
-DllPublic JSValue* CDecl JSContextEvaluateCreate(JSContext* context, JSString* fileName, JSString* code, JSScriptException** outError)
+DllPublic JSObject* CDecl CreateJSClassInstance(JSContext* context, JSClass* cls, void* data, JSScriptException** outError)
 {
 	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		v8::ScriptOrigin origin(fileName->LocalHandle(context));
-		auto script = FromJust(
+		cls->Instantiated = true;
+		auto instance = FromJust(
 			context,
 			tryCatch,
-			v8::Script::Compile(
-				context->LocalHandle(),
-				code->LocalHandle(context),
-				&origin));
+			cls->LocalHandle(context)->InstanceTemplate()->NewInstance(context->LocalHandle()));
 
-		return WrapMaybe(context, tryCatch, script->Run(context->LocalHandle()));
+		JSClassInstanceData* native = nullptr;
+		if (data != nullptr)
+		{
+			native = new JSClassInstanceData{context, {}, data};
+			native->Handle.Reset(context->Isolate, instance);
+			native->Handle.SetWeak(
+				native,
+				[] (const v8::WeakCallbackInfo<JSClassInstanceData>& info)
+				{
+					auto native = info.GetParameter();
+					auto f = native->Context->ExternalFinalizer;
+					if (f != nullptr)
+						f(native->Data);
+					native->Handle.Reset();
+					delete native;
+				},
+				v8::WeakCallbackType::kParameter);
+		}
+		instance->SetAlignedPointerInInternalField(0, native);
+		return NewCachedWrapper<JSObject>(context, JSType::Object, instance);
 	});
 }
 
-DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context)
+DllPublic void* CDecl GetJSClassInstanceData(JSContext* context, JSClass* cls, JSObject* obj, JSRuntimeError* outError)
 {
+	*outError = JSRuntimeError::NoError;
 	V8Scope scope(context);
-	return new JSObject(context->Isolate, context->LocalHandle()->Global());
+	auto localObj = obj->LocalHandle(context);
+	if (!cls->LocalHandle(context)->HasInstance(localObj))
+	{
+		*outError = JSRuntimeError::TypeError;
+		return nullptr;
+	}
+	auto native = static_cast<JSClassInstanceData*>(localObj->GetAlignedPointerFromInternalField(0));
+	return native == nullptr ? nullptr : native->Data;
 }
 
-DllPublic const char* CDecl GetV8Version() { return v8::V8::GetVersion(); }
-
 // -------------------------------------------------------------------------
 // Debug
 DllPublic void CDecl SetJSDebugMessageHandler(JSContext* context, void* data, JSDebugMessageHandler messageHandler)
 {
-	static JSContext* debugContext;
-	debugContext = context;
 	if (context->DebugMessageHandlerData != data || context->DebugMessageHandler != messageHandler)
 	{
 		V8Scope scope(context);
@@ -502,6 +2689,7 @@ DllPublic void CDecl SetJSDebugMessageHandler(JSContext* context, void* data, JS
 			v8::Debug::SetMessageHandler(context->Isolate, [] (const v8::Debug::Message& message)
 			{
 				auto isolate = message.GetIsolate();
+				auto debugContext = static_cast<JSContext*>(isolate->GetData(0));
 				v8::HandleScope handleScope(isolate);
 				debugContext->DebugMessageHandler(debugContext->DebugMessageHandlerData, new JSString(isolate, message.GetJSON()));
 			});
@@ -511,31 +2699,506 @@ DllPublic void CDecl SetJSDebugMessageHandler(JSContext* context, void* data, JS
 	}
 }
 
-DllPublic void CDecl SendJSDebugCommand(JSContext* context, const uint16_t* command, int length)
+DllPublic void CDecl SendJSDebugCommand(JSContext* context, const uint16_t* command, int length)
+{
+	v8::Debug::SendCommand(context->Isolate, command, length);
+}
+
+DllPublic void CDecl ProcessJSDebugMessages(JSContext* context)
+{
+	V8Scope scope(context);
+	v8::Debug::ProcessDebugMessages(context->Isolate);
+}
+
+// -------------------------------------------------------------------------
+// Profiler
+DllPublic void CDecl RetainJSProfile(JSProfile* profile)
+{
+	if (profile != nullptr)
+		profile->Retain();
+}
+
+DllPublic void CDecl ReleaseJSProfile(JSProfile* profile)
+{
+	if (profile != nullptr)
+		profile->Release();
+}
+
+DllPublic int CDecl CopyJSProfileData(JSProfile* profile, char* outBuffer, int bufferLength)
+{
+	auto length = static_cast<int>(profile->Data.size());
+	if (outBuffer != nullptr && length > 0 && bufferLength >= length)
+		memcpy(outBuffer, profile->Data.data(), length);
+	return length;
+}
+
+// Finds title among the running profiles' titles
+static std::vector<ResettingPersistent<v8::String>>::iterator FindCpuProfile(JSContext* context, v8::Local<v8::String> title)
+{
+	auto& titles = context->CpuProfileTitles;
+	for (auto it = titles.begin(); it != titles.end(); ++it)
+	{
+		if (it->Get(context->Isolate)->StrictEquals(title))
+			return it;
+	}
+	return titles.end();
+}
+
+// Stops the profiles still running, which V8 requires before disposing of
+// the profiler
+void JSContext::StopCpuProfiles()
+{
+	if (CpuProfileTitles.empty())
+		return;
+	IsolateEntry entry(Isolate);
+	v8::HandleScope handleScope(Isolate);
+	for (auto& title : CpuProfileTitles)
+	{
+		if (auto profile = CpuProfiler->StopProfiling(title.Get(Isolate)))
+			profile->Delete();
+	}
+	CpuProfileTitles.clear();
+}
+
+DllPublic void CDecl StartJSCpuProfile(JSContext* context, JSString* title, int samplingIntervalMicroseconds)
+{
+	V8Scope scope(context);
+	if (context->CpuProfiler == nullptr)
+		context->CpuProfiler = v8::CpuProfiler::New(context->Isolate);
+	auto localTitle = title->LocalHandle(context);
+	if (FindCpuProfile(context, localTitle) != context->CpuProfileTitles.end())
+		return;
+	// V8 only allows changing the interval while not profiling
+	if (samplingIntervalMicroseconds > 0 && context->CpuProfileTitles.empty())
+		context->CpuProfiler->SetSamplingInterval(samplingIntervalMicroseconds);
+	// The samples give the timeline in the .cpuprofile
+	context->CpuProfiler->StartProfiling(localTitle, true);
+	context->CpuProfileTitles.emplace_back(context->Isolate, localTitle);
+}
+
+DllPublic void CDecl CollectJSCpuProfileSample(JSContext* context)
+{
+	IsolateEntry entry(context->Isolate);
+	if (context->CpuProfiler != nullptr)
+		context->CpuProfiler->CollectSample();
+}
+
+// Appends str, which is UTF-8, as a JSON string
+static void AppendJsonString(std::string& json, const char* str)
+{
+	json += '"';
+	for (auto p = str; p != nullptr && *p != '\0'; ++p)
+	{
+		auto c = static_cast<unsigned char>(*p);
+		if (c == '"' || c == '\\')
+		{
+			json += '\\';
+			json += *p;
+		}
+		else if (c < 0x20)
+		{
+			char escaped[8];
+			snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+			json += escaped;
+		}
+		else
+			json += *p;
+	}
+	json += '"';
+}
+
+// Writes the profile in the .cpuprofile format read by Chrome's DevTools,
+// which has 0-based line and column numbers
+static std::string CpuProfileJson(const v8::CpuProfile* profile)
+{
+	std::string json = "{\"nodes\":[";
+	std::vector<const v8::CpuProfileNode*> pending { profile->GetTopDownRoot() };
+	auto first = true;
+	while (!pending.empty())
+	{
+		auto node = pending.back();
+		pending.pop_back();
+		if (!first)
+			json += ',';
+		first = false;
+
+		json += "{\"id\":" + std::to_string(node->GetNodeId());
+		json += ",\"callFrame\":{\"functionName\":";
+		AppendJsonString(json, node->GetFunctionNameStr());
+		json += ",\"scriptId\":\"" + std::to_string(node->GetScriptId()) + "\"";
+		json += ",\"url\":";
+		AppendJsonString(json, node->GetScriptResourceNameStr());
+		json += ",\"lineNumber\":" + std::to_string(node->GetLineNumber() - 1);
+		json += ",\"columnNumber\":" + std::to_string(node->GetColumnNumber() - 1);
+		json += "},\"hitCount\":" + std::to_string(node->GetHitCount());
+		auto bailoutReason = node->GetBailoutReason();
+		if (bailoutReason != nullptr && *bailoutReason != '\0')
+		{
+			json += ",\"deoptReason\":";
+			AppendJsonString(json, bailoutReason);
+		}
+		json += ",\"children\":[";
+		for (int i = 0; i < node->GetChildrenCount(); ++i)
+		{
+			auto child = node->GetChild(i);
+			if (i > 0)
+				json += ',';
+			json += std::to_string(child->GetNodeId());
+			pending.push_back(child);
+		}
+		json += "]}";
+	}
+	json += "],\"startTime\":" + std::to_string(profile->GetStartTime());
+	json += ",\"endTime\":" + std::to_string(profile->GetEndTime());
+
+	json += ",\"samples\":[";
+	auto sampleCount = profile->GetSamplesCount();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		if (i > 0)
+			json += ',';
+		json += std::to_string(profile->GetSample(i)->GetNodeId());
+	}
+	json += "],\"timeDeltas\":[";
+	auto lastTimestamp = profile->GetStartTime();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		if (i > 0)
+			json += ',';
+		auto timestamp = profile->GetSampleTimestamp(i);
+		json += std::to_string(timestamp - lastTimestamp);
+		lastTimestamp = timestamp;
+	}
+	json += "]}";
+	return json;
+}
+
+DllPublic JSProfile* CDecl StopJSCpuProfile(JSContext* context, JSString* title)
+{
+	V8Scope scope(context);
+	if (context->CpuProfiler == nullptr)
+		return nullptr;
+	auto localTitle = title->LocalHandle(context);
+	auto running = FindCpuProfile(context, localTitle);
+	if (running != context->CpuProfileTitles.end())
+		context->CpuProfileTitles.erase(running);
+	auto cpuProfile = context->CpuProfiler->StopProfiling(localTitle);
+	if (cpuProfile == nullptr)
+		return nullptr;
+	auto profile = new JSProfile();
+	profile->Data = CpuProfileJson(cpuProfile);
+	cpuProfile->Delete();
+	return profile;
+}
+
+struct StringOutputStream : v8::OutputStream
+{
+	std::string& Data;
+	StringOutputStream(std::string& data) : Data(data) { }
+	virtual void EndOfStream() override { }
+	virtual int GetChunkSize() override { return 64 * 1024; }
+	virtual WriteResult WriteAsciiChunk(char* data, int size) override
+	{
+		Data.append(data, static_cast<size_t>(size));
+		return kContinue;
+	}
+};
+
+DllPublic JSProfile* CDecl TakeJSHeapSnapshot(JSContext* context)
+{
+	V8Scope scope(context);
+	auto snapshot = context->Isolate->GetHeapProfiler()->TakeHeapSnapshot();
+	auto profile = new JSProfile();
+	StringOutputStream stream(profile->Data);
+	snapshot->Serialize(&stream, v8::HeapSnapshot::kJSON);
+	const_cast<v8::HeapSnapshot*>(snapshot)->Delete();
+	return profile;
+}
+
+DllPublic bool CDecl SetJSInstrumentationEnabled(bool enabled)
+{
+	if (!InstrumentationBuilt)
+		return false;
+	_instrumentationEnabled = enabled;
+	return true;
+}
+
+DllPublic void CDecl GetJSCallCounter(JSInstrumentedCall call, JSCallCounter* outCounter)
+{
+	auto index = static_cast<int>(call);
+	if (index < 0 || index >= InstrumentedCallCount)
+	{
+		outCounter->Calls = 0;
+		outCounter->Nanoseconds = 0;
+		return;
+	}
+	outCounter->Calls = _callCounters[index].Calls.load();
+	outCounter->Nanoseconds = _callCounters[index].Nanoseconds.load();
+}
+
+DllPublic void CDecl GetJSObjectCounters(JSObjectCounters* outCounters)
+{
+	outCounters->WrapperAllocations = _wrapperAllocations.load();
+	outCounters->LiveObjects = _liveObjects.load();
+}
+
+DllPublic void CDecl ResetJSInstrumentationCounters()
+{
+	for (auto& counter: _callCounters)
+	{
+		counter.Calls = 0;
+		counter.Nanoseconds = 0;
+	}
+	_wrapperAllocations = 0;
+}
+
+static std::mutex _tracingMutex;
+static std::ofstream* _traceStream = nullptr;
+static v8::platform::tracing::TracingController* _tracingController = nullptr;
+
+DllPublic bool CDecl StartJSTracing(const char* path, const char* categories)
+{
+	namespace tracing = v8::platform::tracing;
+
+	InitializeV8();
+	std::lock_guard<std::mutex> lock(_tracingMutex);
+	if (_tracingController != nullptr)
+		return false;
+
+	auto stream = new std::ofstream(path);
+	if (!*stream)
+	{
+		delete stream;
+		return false;
+	}
+
+	auto config = new tracing::TraceConfig();
+	config->SetTraceRecordMode(tracing::RECORD_CONTINUOUSLY);
+	std::string categoryList(categories != nullptr ? categories : "v8simple,v8");
+	size_t begin = 0;
+	while (begin <= categoryList.size())
+	{
+		auto end = categoryList.find(',', begin);
+		if (end == std::string::npos)
+			end = categoryList.size();
+		if (end > begin)
+			config->AddIncludedCategory(categoryList.substr(begin, end - begin).c_str());
+		begin = end + 1;
+	}
+
+	auto controller = new tracing::TracingController();
+	controller->Initialize(tracing::TraceBuffer::CreateTraceBufferRingBuffer(
+		tracing::TraceBuffer::kRingBufferChunks,
+		tracing::TraceWriter::CreateJSONTraceWriter(*stream)));
+	controller->StartTracing(config);
+	// The platform takes ownership of the controller
+	v8::platform::SetTracingController(_platform, controller);
+	_traceCategory = _platform->GetCategoryGroupEnabled("v8simple");
+
+	_traceStream = stream;
+	_tracingController = controller;
+	return true;
+}
+
+DllPublic void CDecl StopJSTracing()
+{
+	std::lock_guard<std::mutex> lock(_tracingMutex);
+	if (_tracingController == nullptr)
+		return;
+
+	_traceCategory = nullptr;
+	_tracingController->StopTracing();
+	// Replacing the controller deletes it along with its trace writer, which
+	// finishes the JSON
+	v8::platform::SetTracingController(_platform, nullptr);
+	_tracingController = nullptr;
+	delete _traceStream;
+	_traceStream = nullptr;
+}
+
+// -------------------------------------------------------------------------
+// Heap
+DllPublic void CDecl GetJSContextHeapStatistics(JSContext* context, JSHeapStatistics* outStatistics)
+{
+	IsolateEntry entry(context->Isolate);
+	v8::HeapStatistics statistics;
+	context->Isolate->GetHeapStatistics(&statistics);
+	outStatistics->TotalHeapSize = static_cast<int64_t>(statistics.total_heap_size());
+	outStatistics->TotalHeapSizeExecutable = static_cast<int64_t>(statistics.total_heap_size_executable());
+	outStatistics->TotalPhysicalSize = static_cast<int64_t>(statistics.total_physical_size());
+	outStatistics->TotalAvailableSize = static_cast<int64_t>(statistics.total_available_size());
+	outStatistics->UsedHeapSize = static_cast<int64_t>(statistics.used_heap_size());
+	outStatistics->HeapSizeLimit = static_cast<int64_t>(statistics.heap_size_limit());
+	outStatistics->MallocedMemory = static_cast<int64_t>(statistics.malloced_memory());
+	outStatistics->PeakMallocedMemory = static_cast<int64_t>(statistics.peak_malloced_memory());
+	// Adjusting by zero just reads the current amount
+	outStatistics->ExternalMemory = context->Isolate->AdjustAmountOfExternalAllocatedMemory(0);
+}
+
+DllPublic int CDecl GetJSContextHeapSpaceCount(JSContext* context)
+{
+	IsolateEntry entry(context->Isolate);
+	return static_cast<int>(context->Isolate->NumberOfHeapSpaces());
+}
+
+DllPublic bool CDecl GetJSContextHeapSpaceStatistics(JSContext* context, int index, JSHeapSpaceStatistics* outStatistics)
+{
+	*outStatistics = JSHeapSpaceStatistics { nullptr, 0, 0, 0, 0 };
+	if (index < 0)
+		return false;
+	IsolateEntry entry(context->Isolate);
+	v8::HeapSpaceStatistics statistics;
+	if (!context->Isolate->GetHeapSpaceStatistics(&statistics, static_cast<size_t>(index)))
+		return false;
+	outStatistics->Name = statistics.space_name();
+	outStatistics->SpaceSize = static_cast<int64_t>(statistics.space_size());
+	outStatistics->SpaceUsedSize = static_cast<int64_t>(statistics.space_used_size());
+	outStatistics->SpaceAvailableSize = static_cast<int64_t>(statistics.space_available_size());
+	outStatistics->PhysicalSpaceSize = static_cast<int64_t>(statistics.physical_space_size());
+	return true;
+}
+
+DllPublic void CDecl NotifyJSMemoryPressure(JSContext* context, JSMemoryPressureLevel level)
+{
+	v8::MemoryPressureLevel v8Level = v8::MemoryPressureLevel::kNone;
+	switch (level)
+	{
+		case JSMemoryPressureLevel::None: v8Level = v8::MemoryPressureLevel::kNone; break;
+		case JSMemoryPressureLevel::Moderate: v8Level = v8::MemoryPressureLevel::kModerate; break;
+		case JSMemoryPressureLevel::Critical: v8Level = v8::MemoryPressureLevel::kCritical; break;
+	}
+	// Allowed without the lock, so that it doesn't wait for running script
+	context->Isolate->MemoryPressureNotification(v8Level);
+	if (level == JSMemoryPressureLevel::Critical)
+		context->Allocator->Trim();
+}
+
+DllPublic bool CDecl NotifyJSIdle(JSContext* context, double idleMilliseconds)
+{
+	IsolateEntry entry(context->Isolate);
+	// The deadline is in the platform's time base
+	auto deadline = _platform->MonotonicallyIncreasingTime() + idleMilliseconds / 1000.0;
+	return context->Isolate->IdleNotificationDeadline(deadline);
+}
+
+DllPublic void CDecl NotifyJSLowMemory(JSContext* context)
+{
+	IsolateEntry entry(context->Isolate);
+	context->Isolate->LowMemoryNotification();
+	context->Allocator->Trim();
+}
+
+DllPublic void CDecl GetJSContextArrayBufferStatistics(JSContext* context, JSArrayBufferStatistics* outStatistics)
+{
+	// The counters are atomic, so this doesn't need the lock
+	auto allocator = context->Allocator;
+	outStatistics->AllocationCount = allocator->AllocationCount;
+	outStatistics->FreeCount = allocator->FreeCount;
+	outStatistics->AllocatedBytes = allocator->AllocatedBytes;
+	outStatistics->PoolHitCount = allocator->PoolHitCount;
+	outStatistics->PooledBytes = allocator->PooledBytes;
+	outStatistics->LargeAllocationCount = allocator->LargeAllocationCount;
+}
+
+DllPublic int64_t CDecl AdjustJSExternalMemory(JSContext* context, int64_t changeInBytes)
+{
+	IsolateEntry entry(context->Isolate);
+	return context->Isolate->AdjustAmountOfExternalAllocatedMemory(changeInBytes);
+}
+
+static void GCPrologue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags)
+{
+	auto context = static_cast<JSContext*>(isolate->GetData(0));
+	context->GCStart = std::chrono::steady_clock::now();
+}
+
+static void GCEpilogue(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags)
+{
+	auto context = static_cast<JSContext*>(isolate->GetData(0));
+	if (context->GCEventHandler != nullptr)
+	{
+		std::chrono::duration<double, std::milli> pause = std::chrono::steady_clock::now() - context->GCStart;
+		context->GCEventHandler(context->GCEventHandlerData, static_cast<JSGCType>(type), pause.count());
+	}
+	// V8 5.5 has no near heap limit callback, so check after each collection
+	if (context->NearHeapLimitHandler != nullptr)
+	{
+		v8::HeapStatistics statistics;
+		isolate->GetHeapStatistics(&statistics);
+		auto limit = statistics.heap_size_limit() / 100 * static_cast<size_t>(context->NearHeapLimitPercent);
+		auto nearLimit = statistics.used_heap_size() >= limit;
+		if (nearLimit && !context->NearHeapLimitReported)
+		{
+			context->NearHeapLimitHandler(
+				context,
+				context->NearHeapLimitHandlerData,
+				static_cast<int64_t>(statistics.used_heap_size()),
+				static_cast<int64_t>(statistics.heap_size_limit()));
+		}
+		context->NearHeapLimitReported = nearLimit;
+	}
+}
+
+// Installs the GC callbacks while there's a handler that needs them
+static void UpdateGCCallbacks(JSContext* context)
+{
+	auto needed = context->GCEventHandler != nullptr || context->NearHeapLimitHandler != nullptr;
+	if (needed == context->GCCallbacksInstalled)
+		return;
+	if (needed)
+	{
+		context->Isolate->AddGCPrologueCallback(GCPrologue);
+		context->Isolate->AddGCEpilogueCallback(GCEpilogue);
+	}
+	else
+	{
+		context->Isolate->RemoveGCPrologueCallback(GCPrologue);
+		context->Isolate->RemoveGCEpilogueCallback(GCEpilogue);
+	}
+	context->GCCallbacksInstalled = needed;
+}
+
+DllPublic void CDecl SetJSGCEventHandler(JSContext* context, void* data, JSGCEventHandler handler)
 {
-	v8::Debug::SendCommand(context->Isolate, command, length);
-}
+	if (context->GCEventHandlerData == data && context->GCEventHandler == handler)
+		return;
 
-DllPublic void CDecl ProcessJSDebugMessages(JSContext* context)
-{
-	V8Scope scope(context);
-	v8::Debug::ProcessDebugMessages(context->Isolate);
+	IsolateEntry entry(context->Isolate);
+	auto oldData = context->GCEventHandlerData;
+	context->GCEventHandler = handler;
+	context->GCEventHandlerData = handler == nullptr ? nullptr : data;
+	UpdateGCCallbacks(context);
+	if (context->ExternalFinalizer != nullptr && oldData != nullptr && oldData != data)
+		context->ExternalFinalizer(oldData);
 }
 
 // -------------------------------------------------------------------------
 // Value
-DllPublic JSType CDecl GetJSValueType(JSValue* value) { return value == nullptr ? JSType::Null : value->Type(); }
+DllPublic JSType CDecl GetJSValueType(JSValue* value)
+{
+	switch (ImmediateTag(value))
+	{
+		case ImmediateIntTag: return JSType::Int;
+		case ImmediateBoolTag: return JSType::Bool;
+		case ImmediateDoubleTag: return JSType::Double;
+		default: return value == nullptr ? JSType::Null : value->Type();
+	}
+}
 DllPublic void CDecl RetainJSValue(JSContext* context, JSValue* value)
 {
-	if (value != nullptr)
-		value->Retain();
+	RetainValue(value);
 }
 DllPublic void CDecl ReleaseJSValue(JSContext* context, JSValue* value)
 {
-	if (value != nullptr && context != nullptr)
+	if (value == nullptr || IsImmediate(value))
 	{
-		v8::Locker(context->Isolate);
-		value->Release();
+		// Nothing to release
+	}
+	else if (context != nullptr)
+	{
+		// Destroying a wrapper resets its handle and may touch the context's
+		// identity cache
+		ReleaseFromAnyThread(context, value);
 	}
 	else
 	{
@@ -551,7 +3214,7 @@ DllPublic int CDecl JSValueAsInt(JSValue* value, JSRuntimeError* outError)
 		*outError = JSRuntimeError::InvalidCast;
 		return 0;
 	}
-	return static_cast<JSInt*>(value)->Value;
+	return IntValue(value);
 }
 
 DllPublic double CDecl JSValueAsDouble(JSValue* value, JSRuntimeError* outError)
@@ -562,7 +3225,7 @@ DllPublic double CDecl JSValueAsDouble(JSValue* value, JSRuntimeError* outError)
 		*outError = JSRuntimeError::InvalidCast;
 		return 0.0;
 	}
-	return static_cast<JSDouble*>(value)->Value;
+	return DoubleValue(value);
 }
 
 DllPublic JSString* CDecl JSValueAsString(JSValue* value, JSRuntimeError* outError)
@@ -584,14 +3247,14 @@ DllPublic bool CDecl JSValueAsBool(JSValue* value, JSRuntimeError* outError)
 		*outError = JSRuntimeError::InvalidCast;
 		return false;
 	}
-	return static_cast<JSBool*>(value)->Value;
+	return BoolValue(value);
 }
 
 DllPublic JSObject* CDecl JSValueAsObject(JSValue* value, JSRuntimeError* outError)
 {
 	*outError = JSRuntimeError::NoError;
 	auto type = GetJSValueType(value);
-	if (type != JSType::Object && type != JSType::Null)
+	if (type != JSType::Object && type != JSType::Promise && type != JSType::Null)
 	{
 		*outError = JSRuntimeError::InvalidCast;
 		return nullptr;
@@ -634,6 +3297,9 @@ DllPublic JSExternal* CDecl JSValueAsExternal(JSValue* value, JSRuntimeError* ou
 
 DllPublic bool CDecl JSValueStrictEquals(JSContext* context, JSValue* obj1, JSValue* obj2)
 {
+	// Identical wrappers are the same value, except for NaN
+	if (obj1 == obj2 && GetJSValueType(obj1) != JSType::Double)
+		return true;
 	V8Scope scope(context);
 	return Unwrap(context->Isolate, obj1)->StrictEquals(Unwrap(context->Isolate, obj2));
 }
@@ -641,9 +3307,9 @@ DllPublic bool CDecl JSValueStrictEquals(JSContext* context, JSValue* obj1, JSVa
 // --------------------------------------------------------------------------
 // Primitives
 DllPublic JSValue* CDecl JSNull() { return nullptr; }
-DllPublic JSValue* CDecl CreateJSInt(int value) { return new JSInt(value); }
-DllPublic JSValue* CDecl CreateJSDouble(double value) { return new JSDouble(value); }
-DllPublic JSValue* CDecl CreateJSBool(bool value) { return new JSBool(value); }
+DllPublic JSValue* CDecl CreateJSInt(int value) { return NewJSInt(value); }
+DllPublic JSValue* CDecl CreateJSDouble(double value) { return NewJSDouble(value); }
+DllPublic JSValue* CDecl CreateJSBool(bool value) { return NewJSBool(value); }
 
 DllPublic JSObject* CDecl CreateExternalJSArrayBuffer(JSContext* context, void* data, int byteLength)
 {
@@ -651,25 +3317,144 @@ DllPublic JSObject* CDecl CreateExternalJSArrayBuffer(JSContext* context, void*
 	return new JSObject(context->Isolate, v8::ArrayBuffer::New(context->Isolate, data, (size_t)byteLength));
 }
 
-DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSCallback callback, JSScriptException** outError)
+DllPublic JSObject* CDecl CreateSizedExternalJSArrayBuffer(JSContext* context, void* data, int byteLength, void* finalizerData, JSRuntimeError* outError)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	*outError = JSRuntimeError::NoError;
+	if (byteLength < 0)
+	{
+		*outError = JSRuntimeError::RangeError;
+		return nullptr;
+	}
+	V8Scope scope(context);
+
+	auto localBuffer = v8::ArrayBuffer::New(context->Isolate, data, (size_t)byteLength);
+
+	struct Closure
 	{
-		struct Closure
+		ResettingPersistent<v8::ArrayBuffer> finalizer;
+		JSExternalFinalizer externalFinalizer;
+		void* finalizerData;
+		int64_t size;
+	};
+
+	auto closure = new Closure{{}, context->ExternalFinalizer, finalizerData, byteLength};
+	closure->finalizer.Reset(context->Isolate, localBuffer);
+	context->Isolate->AdjustAmountOfExternalAllocatedMemory(closure->size);
+
+	closure->finalizer.SetWeak(
+		closure,
+		[] (const v8::WeakCallbackInfo<Closure>& data)
 		{
-			JSContext* context;
-			ResettingPersistent<v8::External> finalizer;
-			void* data;
-			JSCallback callback;
-		};
-		auto closure = new Closure{context, {}, data, callback};
+			auto closure = data.GetParameter();
+			if (closure->externalFinalizer != nullptr && closure->finalizerData != nullptr)
+				closure->externalFinalizer(closure->finalizerData);
+			data.GetIsolate()->AdjustAmountOfExternalAllocatedMemory(-closure->size);
+			closure->finalizer.Reset();
+			delete closure;
+		},
+		v8::WeakCallbackType::kParameter);
+
+	return new JSObject(context->Isolate, localBuffer);
+}
+
+DllPublic JSObject* CDecl CreateJSArrayBuffer(JSContext* context, int byteLength, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	if (byteLength < 0)
+	{
+		*outError = JSRuntimeError::RangeError;
+		return nullptr;
+	}
+	V8Scope scope(context);
+	return new JSObject(context->Isolate, v8::ArrayBuffer::New(context->Isolate, (size_t)byteLength));
+}
+
+static int TypedArrayElementSize(JSTypedArrayType type)
+{
+	switch (type)
+	{
+		case JSTypedArrayType::Int8:
+		case JSTypedArrayType::Uint8:
+		case JSTypedArrayType::Uint8Clamped:
+			return 1;
+		case JSTypedArrayType::Int16:
+		case JSTypedArrayType::Uint16:
+			return 2;
+		case JSTypedArrayType::Int32:
+		case JSTypedArrayType::Uint32:
+		case JSTypedArrayType::Float32:
+			return 4;
+		case JSTypedArrayType::Float64:
+			return 8;
+	}
+	return 0;
+}
+
+static v8::Local<v8::TypedArray> NewTypedArray(
+	JSTypedArrayType type,
+	v8::Local<v8::ArrayBuffer> buffer,
+	size_t byteOffset,
+	size_t length)
+{
+	switch (type)
+	{
+		case JSTypedArrayType::Int8: return v8::Int8Array::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Uint8: return v8::Uint8Array::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Uint8Clamped: return v8::Uint8ClampedArray::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Int16: return v8::Int16Array::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Uint16: return v8::Uint16Array::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Int32: return v8::Int32Array::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Uint32: return v8::Uint32Array::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Float32: return v8::Float32Array::New(buffer, byteOffset, length);
+		case JSTypedArrayType::Float64: return v8::Float64Array::New(buffer, byteOffset, length);
+	}
+	return v8::Local<v8::TypedArray>();
+}
+
+DllPublic JSObject* CDecl CreateJSTypedArray(JSContext* context, JSObject* arrayBuffer, JSTypedArrayType type, int byteOffset, int length, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	V8Scope scope(context);
+	auto localBuffer = arrayBuffer->LocalHandle(context);
+	auto elementSize = TypedArrayElementSize(type);
+	if (!localBuffer->IsArrayBuffer() || elementSize == 0)
+	{
+		*outError = JSRuntimeError::TypeError;
+		return nullptr;
+	}
+	auto buffer = localBuffer.As<v8::ArrayBuffer>();
+	// V8 aborts on views that are out of bounds or misaligned
+	if (byteOffset < 0
+		|| length < 0
+		|| byteOffset % elementSize != 0
+		|| (size_t)byteOffset + (size_t)length * elementSize > buffer->ByteLength())
+	{
+		*outError = JSRuntimeError::RangeError;
+		return nullptr;
+	}
+	return new JSObject(context->Isolate, NewTypedArray(type, buffer, (size_t)byteOffset, (size_t)length));
+}
+
+// The data of a callback function. Calls the context's callback finalizer
+// when the function is garbage collected.
+template<typename Callback>
+struct CallbackClosure
+{
+	JSContext* context;
+	ResettingPersistent<v8::External> finalizer;
+	void* data;
+	Callback callback;
+
+	static v8::Local<v8::External> New(JSContext* context, void* data, Callback callback)
+	{
+		auto closure = new CallbackClosure{context, {}, data, callback};
 
 		auto localClosure = v8::External::New(context->Isolate, closure);
 		closure->finalizer.Reset(context->Isolate, localClosure);
 
 		closure->finalizer.SetWeak(
 			closure,
-			[] (const v8::WeakCallbackInfo<Closure>& data)
+			[] (const v8::WeakCallbackInfo<CallbackClosure>& data)
 			{
 				auto closure = data.GetParameter();
 				auto f = closure->context->CallbackFinalizer;
@@ -679,6 +3464,16 @@ DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSC
 				delete closure;
 			},
 			v8::WeakCallbackType::kParameter);
+		return localClosure;
+	}
+};
+
+DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSCallback callback, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		typedef CallbackClosure<JSCallback> Closure;
+		auto localClosure = Closure::New(context, data, callback);
 
 		struct AutoReleaser
 		{
@@ -688,8 +3483,7 @@ DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSC
 			{
 				for (auto v : _values)
 				{
-					if (v != nullptr)
-						v->Release();
+					ReleaseValue(v);
 				}
 			}
 		};
@@ -699,6 +3493,7 @@ DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSC
 				context->LocalHandle(),
 				[] (const v8::FunctionCallbackInfo<v8::Value>& info)
 				{
+					InstrumentedCall instrumented(JSInstrumentedCall::Callback, "JSCallback");
 					auto isolate = info.GetIsolate();
 					v8::HandleScope handleScope(isolate);
 					Closure* closure =
@@ -712,30 +3507,28 @@ DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSC
 
 					try
 					{
-						{
-							v8::TryCatch tryCatch;
-							for (int i = 0; i < numArgs; ++i)
-								args[i] = Wrap(closure->context, tryCatch, info[i]);
-						}
+						for (int i = 0; i < numArgs; ++i)
+							args[i] = Wrap(closure->context, info[i]);
 
 						JSValue* error = nullptr;
 						JSValue* result = closure->callback(closure->context, closure->data, data_ptr(args), numArgs, &error);
 
 						info.GetReturnValue().Set(Unwrap(isolate, result));
 
-						if (result != nullptr)
-							result->Release();
+						ReleaseValue(result);
 
 						if (error != nullptr)
 						{
 							auto unwrappedError = Unwrap(isolate, error);
-							error->Release();
+							ReleaseValue(error);
 							isolate->ThrowException(unwrappedError);
 						}
 					}
 					catch (JSScriptException* error)
 					{
-						auto unwrappedError = Unwrap(isolate, error->Exception);
+						auto unwrappedError = error->ExceptionHandle.IsEmpty()
+							? v8::Null(isolate).As<v8::Value>()
+							: error->ExceptionHandle.Get(isolate);
 						error->Release();
 						isolate->ThrowException(unwrappedError);
 					}
@@ -744,6 +3537,29 @@ DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSC
 	});
 }
 
+DllPublic JSFunction* CDecl CreateJSFastCallback(JSContext* context, void* data, JSFastCallback callback, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		typedef CallbackClosure<JSFastCallback> Closure;
+		auto localClosure = Closure::New(context, data, callback);
+
+		return new JSFunction(context->Isolate,
+			FromJust(context, tryCatch, v8::Function::New(
+				context->LocalHandle(),
+				[] (const v8::FunctionCallbackInfo<v8::Value>& info)
+				{
+					v8::HandleScope handleScope(info.GetIsolate());
+					Closure* closure =
+						static_cast<Closure*>(info.Data().
+							As<v8::External>()
+							->Value());
+					InvokeFastCallback(info, closure->context, closure->data, closure->callback, false);
+				},
+				localClosure.As<v8::Value>())));
+	});
+}
+
 // --------------------------------------------------------------------------
 // String
 DllPublic JSString* CDecl CreateJSString(JSContext* context, const uint16_t* buffer, int length, JSRuntimeError* outError)
@@ -759,6 +3575,100 @@ DllPublic JSString* CDecl CreateJSString(JSContext* context, const uint16_t* buf
 	return new JSString(context->Isolate, mstr.ToLocalChecked());
 }
 
+DllPublic JSString* CDecl CreateJSPropertyKey(JSContext* context, const uint16_t* buffer, int length, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	// The cache only needs the lock
+	IsolateEntry entry(context->Isolate);
+	auto chars = reinterpret_cast<const char16_t*>(buffer);
+	// Null-terminated, as with CreateJSString, when negative
+	std::u16string key(chars, length < 0 ? std::char_traits<char16_t>::length(chars) : static_cast<size_t>(length));
+	auto it = context->PropertyKeys.find(key);
+	if (it != context->PropertyKeys.end())
+	{
+		it->second->Retain();
+		return it->second;
+	}
+	V8Scope scope(context);
+	auto mstr = v8::String::NewFromTwoByte(context->Isolate, buffer, v8::NewStringType::kInternalized, static_cast<int>(key.size()));
+	if (mstr.IsEmpty())
+	{
+		*outError = JSRuntimeError::StringTooLong;
+		return nullptr;
+	}
+	auto result = new JSString(context->Isolate, mstr.ToLocalChecked());
+	// One reference for the cache, one for the caller
+	result->Retain();
+	context->PropertyKeys.emplace(std::move(key), result);
+	return result;
+}
+
+// Hands the caller's buffer back through the context's ExternalFinalizer when
+// V8 is done with the string.
+template<class Resource, class Char>
+struct ExternalStringResource : Resource
+{
+	const Char* const Buffer;
+	const size_t Length;
+	JSExternalFinalizer Finalizer;
+	void* Data;
+
+	ExternalStringResource(const Char* buffer, size_t length, JSExternalFinalizer finalizer, void* data)
+		: Buffer(buffer)
+		, Length(length)
+		, Finalizer(finalizer)
+		, Data(data)
+	{
+	}
+
+	virtual ~ExternalStringResource() override
+	{
+		if (Finalizer != nullptr && Data != nullptr)
+			Finalizer(Data);
+	}
+
+	virtual const Char* data() const override { return Buffer; }
+	virtual size_t length() const override { return Length; }
+};
+
+template<class Resource, class Char, class NewFunction>
+static JSString* CreateExternalString(JSContext* context, const Char* buffer, int length, void* data, JSRuntimeError* outError, NewFunction newString)
+{
+	*outError = JSRuntimeError::NoError;
+	V8Scope scope(context);
+	auto resource = new ExternalStringResource<Resource, Char>(buffer, static_cast<size_t>(length), context->ExternalFinalizer, data);
+	auto mstr = newString(context->Isolate, resource);
+	if (mstr.IsEmpty())
+	{
+		// V8 didn't take the resource, so the buffer still belongs to the caller
+		resource->Finalizer = nullptr;
+		delete resource;
+		*outError = JSRuntimeError::StringTooLong;
+		return nullptr;
+	}
+	return new JSString(context->Isolate, mstr.ToLocalChecked());
+}
+
+DllPublic JSString* CDecl CreateExternalJSString(JSContext* context, const uint16_t* buffer, int length, void* data, JSRuntimeError* outError)
+{
+	return CreateExternalString<v8::String::ExternalStringResource>(
+		context, buffer, length, data, outError,
+		[] (v8::Isolate* isolate, v8::String::ExternalStringResource* resource)
+		{
+			return v8::String::NewExternalTwoByte(isolate, resource);
+		});
+}
+
+DllPublic JSString* CDecl CreateExternalOneByteJSString(JSContext* context, const char* buffer, int length, void* data, JSRuntimeError* outError)
+{
+	return CreateExternalString<v8::String::ExternalOneByteStringResource>(
+		context, buffer, length, data, outError,
+		[] (v8::Isolate* isolate, v8::String::ExternalOneByteStringResource* resource)
+		{
+			return v8::String::NewExternalOneByte(isolate, resource);
+		});
+}
+
 DllPublic int CDecl JSStringLength(JSContext* context, JSString* string)
 {
 	V8Scope scope(context);
@@ -771,15 +3681,54 @@ DllPublic void CDecl WriteJSStringBuffer(JSContext* context, JSString* string, u
 	string->LocalHandle(context)->Write(outBuffer, 0, -1, nullTerminate ? v8::String::NO_OPTIONS : v8::String::NO_NULL_TERMINATION);
 }
 
+static int WriteUtf16(v8::Local<v8::String> localString, uint16_t* outBuffer, int bufferLength)
+{
+	auto length = localString->Length();
+	if (outBuffer != nullptr && length > 0 && length <= bufferLength)
+		localString->Write(outBuffer, 0, length, v8::String::NO_NULL_TERMINATION);
+	return length;
+}
+
+static int WriteUtf8(v8::Local<v8::String> localString, char* outBuffer, int bufferLength)
+{
+	int charsWritten = 0;
+	int bytesWritten = 0;
+	if (outBuffer != nullptr && bufferLength > 0)
+	{
+		bytesWritten = localString->WriteUtf8(
+			outBuffer,
+			bufferLength,
+			&charsWritten,
+			v8::String::NO_NULL_TERMINATION | v8::String::REPLACE_INVALID_UTF8);
+	}
+	// Only measure the string when it didn't fit
+	return charsWritten == localString->Length()
+		? bytesWritten
+		: localString->Utf8Length();
+}
+
+DllPublic int CDecl WriteJSStringUtf16(JSContext* context, JSString* string, uint16_t* outBuffer, int bufferLength)
+{
+	V8Scope scope(context);
+	return WriteUtf16(string->LocalHandle(context), outBuffer, bufferLength);
+}
+
+DllPublic int CDecl WriteJSStringUtf8(JSContext* context, JSString* string, char* outBuffer, int bufferLength)
+{
+	V8Scope scope(context);
+	return WriteUtf8(string->LocalHandle(context), outBuffer, bufferLength);
+}
+
 DllPublic JSValue* CDecl JSStringAsValue(JSString* string) { return static_cast<JSValue*>(string); }
 
 // -------------------------------------------------------------------------
 // Object
 DllPublic JSValue* CDecl CopyJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSScriptException** outError)
 {
+	InstrumentedCall instrumented(JSInstrumentedCall::CopyProperty, "CopyJSObjectProperty");
 	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		return WrapMaybe(
+		return WrapResult(
 			context,
 			tryCatch,
 			obj->LocalHandle(context)->Get(
@@ -790,6 +3739,7 @@ DllPublic JSValue* CDecl CopyJSObjectProperty(JSContext* context, JSObject* obj,
 
 DllPublic void CDecl SetJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSValue* value, JSScriptException** outError)
 {
+	InstrumentedCall instrumented(JSInstrumentedCall::SetProperty, "SetJSObjectProperty");
 	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
 		FromJust(context, tryCatch, obj->LocalHandle(context)->Set(
@@ -799,12 +3749,76 @@ DllPublic void CDecl SetJSObjectProperty(JSContext* context, JSObject* obj, JSSt
 	});
 }
 
+// Fills outValues with copyAt(0) ... copyAt(count - 1). If one of them
+// throws, the values copied so far are released and outValues is left null.
+template<typename T>
+static void CopyValues(JSContext* context, JSValue** outValues, int count, T copyAt)
+{
+	for (int i = 0; i < count; ++i)
+		outValues[i] = nullptr;
+
+	int copied = 0;
+	try
+	{
+		for (; copied < count; ++copied)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			outValues[copied] = copyAt(copied);
+		}
+	}
+	catch (JSScriptException*)
+	{
+		for (int i = 0; i < copied; ++i)
+		{
+			ReleaseValue(outValues[i]);
+			outValues[i] = nullptr;
+		}
+		throw;
+	}
+}
+
+DllPublic void CDecl CopyJSObjectProperties(JSContext* context, JSObject* obj, JSString* const* keys, JSValue** outValues, int count, JSScriptException** outError)
+{
+	InstrumentedCall instrumented(JSInstrumentedCall::CopyProperty, "CopyJSObjectProperties");
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localContext = context->LocalHandle();
+		auto localObj = obj->LocalHandle(context);
+		CopyValues(context, outValues, count, [&] (int i)
+		{
+			return WrapMaybe(
+				context,
+				tryCatch,
+				localObj->Get(localContext, keys[i]->LocalHandle(context)));
+		});
+	});
+}
+
+DllPublic void CDecl SetJSObjectProperties(JSContext* context, JSObject* obj, JSString* const* keys, JSValue* const* values, int count, JSScriptException** outError)
+{
+	InstrumentedCall instrumented(JSInstrumentedCall::SetProperty, "SetJSObjectProperties");
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto localContext = context->LocalHandle();
+		auto localObj = obj->LocalHandle(context);
+		for (int i = 0; i < count; ++i)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			FromJust(context, tryCatch, localObj->Set(
+				localContext,
+				keys[i]->LocalHandle(context),
+				Unwrap(context->Isolate, values[i])));
+		}
+	});
+}
+
 DllPublic JSArray* CDecl CopyJSObjectOwnPropertyNames(JSContext* context, JSObject* obj, JSScriptException** outError)
 {
 	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		return new JSArray(
-			context->Isolate,
+		return NewCachedWrapper<JSArray>(
+			context,
+			JSType::Array,
 			FromJust(
 				context,
 				tryCatch,
@@ -836,32 +3850,145 @@ DllPublic void* CDecl GetJSObjectArrayBufferData(JSContext* context, JSObject* o
 	return localObj.As<v8::ArrayBuffer>()->GetContents().Data();
 }
 
+DllPublic int CDecl GetJSObjectArrayBufferByteLength(JSContext* context, JSObject* obj, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	V8Scope scope(context);
+	auto localObj = obj->LocalHandle(context);
+	if (!localObj->IsArrayBuffer())
+	{
+		*outError = JSRuntimeError::TypeError;
+		return 0;
+	}
+	return static_cast<int>(localObj.As<v8::ArrayBuffer>()->ByteLength());
+}
+
+static JSTypedArrayType TypedArrayType(v8::Local<v8::Object> typedArray)
+{
+	if (typedArray->IsInt8Array()) return JSTypedArrayType::Int8;
+	if (typedArray->IsUint8Array()) return JSTypedArrayType::Uint8;
+	if (typedArray->IsUint8ClampedArray()) return JSTypedArrayType::Uint8Clamped;
+	if (typedArray->IsInt16Array()) return JSTypedArrayType::Int16;
+	if (typedArray->IsUint16Array()) return JSTypedArrayType::Uint16;
+	if (typedArray->IsInt32Array()) return JSTypedArrayType::Int32;
+	if (typedArray->IsUint32Array()) return JSTypedArrayType::Uint32;
+	if (typedArray->IsFloat32Array()) return JSTypedArrayType::Float32;
+	return JSTypedArrayType::Float64;
+}
+
+DllPublic void CDecl GetJSObjectTypedArrayInfo(JSContext* context, JSObject* obj, JSTypedArrayInfo* outInfo, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	*outInfo = JSTypedArrayInfo { JSTypedArrayType::Int8, 0, 0, 0, nullptr };
+	V8Scope scope(context);
+	auto localObj = obj->LocalHandle(context);
+	if (!localObj->IsTypedArray())
+	{
+		*outError = JSRuntimeError::TypeError;
+		return;
+	}
+	auto typedArray = localObj.As<v8::TypedArray>();
+	auto byteOffset = typedArray->ByteOffset();
+	outInfo->Type = TypedArrayType(localObj);
+	outInfo->Length = static_cast<int>(typedArray->Length());
+	outInfo->ByteOffset = static_cast<int>(byteOffset);
+	outInfo->ByteLength = static_cast<int>(typedArray->ByteLength());
+	// Buffer() moves small on-heap arrays off the heap, so Data stays put
+	outInfo->Data = static_cast<uint8_t*>(typedArray->Buffer()->GetContents().Data()) + byteOffset;
+}
+
+DllPublic JSObject* CDecl CopyJSObjectTypedArrayBuffer(JSContext* context, JSObject* obj, JSRuntimeError* outError)
+{
+	*outError = JSRuntimeError::NoError;
+	V8Scope scope(context);
+	auto localObj = obj->LocalHandle(context);
+	if (!localObj->IsTypedArray())
+	{
+		*outError = JSRuntimeError::TypeError;
+		return nullptr;
+	}
+	return NewCachedWrapper<JSObject>(context, JSType::Object, localObj.As<v8::TypedArray>()->Buffer());
+}
+
 DllPublic JSValue* CDecl JSObjectAsValue(JSObject* obj) { return static_cast<JSValue*>(obj); }
 
 // -------------------------------------------------------------------------
 // Array
 DllPublic JSValue* CDecl CopyJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSScriptException** outError)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	InstrumentedCall instrumented(JSInstrumentedCall::CopyProperty, "CopyJSArrayPropertyAtIndex");
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WrapResult(
+			context,
+			tryCatch,
+			arr->LocalHandle(context)->Get(context->LocalHandle(), index));
+	});
+}
+
+DllPublic void CDecl SetJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSValue* value, JSScriptException** outError)
+{
+	InstrumentedCall instrumented(JSInstrumentedCall::SetProperty, "SetJSArrayPropertyAtIndex");
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		FromJust(
+			context,
+			tryCatch,
+			arr->LocalHandle(context)->Set(
+				context->LocalHandle(),
+				static_cast<uint32_t>(index),
+				Unwrap(context->Isolate, value)));
+	});
+}
+
+static bool IsValidArrayRange(int start, int count, JSRuntimeError* outRuntimeError)
+{
+	*outRuntimeError = JSRuntimeError::NoError;
+	// start + count must not wrap around the uint32_t indices
+	if (start < 0 || count < 0 || start > INT_MAX - count)
+	{
+		*outRuntimeError = JSRuntimeError::RangeError;
+		return false;
+	}
+	return true;
+}
+
+DllPublic void CDecl CopyJSArrayRange(JSContext* context, JSArray* arr, int start, int count, JSValue** outValues, JSRuntimeError* outRuntimeError, JSScriptException** outError)
+{
+	*outError = nullptr;
+	if (!IsValidArrayRange(start, count, outRuntimeError))
+		return;
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		return WrapMaybe(
-			context,
-			tryCatch,
-			arr->LocalHandle(context)->Get(context->LocalHandle(), index));
+		auto localContext = context->LocalHandle();
+		auto localArr = arr->LocalHandle(context);
+		CopyValues(context, outValues, count, [&] (int i)
+		{
+			return WrapMaybe(
+				context,
+				tryCatch,
+				localArr->Get(localContext, static_cast<uint32_t>(start + i)));
+		});
 	});
 }
 
-DllPublic void CDecl SetJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSValue* value, JSScriptException** outError)
+DllPublic void CDecl SetJSArrayRange(JSContext* context, JSArray* arr, int start, int count, JSValue* const* values, JSRuntimeError* outRuntimeError, JSScriptException** outError)
 {
-	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	*outError = nullptr;
+	if (!IsValidArrayRange(start, count, outRuntimeError))
+		return;
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
-		FromJust(
-			context,
-			tryCatch,
-			arr->LocalHandle(context)->Set(
-				context->LocalHandle(),
-				static_cast<uint32_t>(index),
-				Unwrap(context->Isolate, value)));
+		auto localContext = context->LocalHandle();
+		auto localArr = arr->LocalHandle(context);
+		for (int i = 0; i < count; ++i)
+		{
+			v8::HandleScope handleScope(context->Isolate);
+			FromJust(context, tryCatch, localArr->Set(
+				localContext,
+				static_cast<uint32_t>(start + i),
+				Unwrap(context->Isolate, values[i])));
+		}
 	});
 }
 
@@ -877,6 +4004,7 @@ DllPublic JSValue* CDecl JSArrayAsValue(JSArray* arr) { return static_cast<JSVal
 // Function
 DllPublic JSValue* CDecl CallJSFunctionCreate(JSContext* context, JSFunction* function, JSObject* thisObject, JSValue* const* args, int numArgs, JSScriptException** outError)
 {
+	InstrumentedCall instrumented(JSInstrumentedCall::CallFunction, "CallJSFunctionCreate");
 	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
 		std::vector<v8::Local<v8::Value>> unwrappedArgs(numArgs);
@@ -884,7 +4012,7 @@ DllPublic JSValue* CDecl CallJSFunctionCreate(JSContext* context, JSFunction* fu
 		for (int i = 0; i < numArgs; ++i)
 			unwrappedArgs[i] = Unwrap(context->Isolate, args[i]);
 
-		return WrapMaybe(
+		return WrapResult(
 			context,
 			tryCatch,
 			function->LocalHandle(context)->Call(
@@ -898,6 +4026,7 @@ DllPublic JSValue* CDecl CallJSFunctionCreate(JSContext* context, JSFunction* fu
 
 DllPublic JSObject* CDecl ConstructJSFunctionCreate(JSContext* context, JSFunction* function, JSValue* const* args, int numArgs, JSScriptException** outError)
 {
+	InstrumentedCall instrumented(JSInstrumentedCall::ConstructFunction, "ConstructJSFunctionCreate");
 	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
 	{
 		std::vector<v8::Local<v8::Value>> unwrappedArgs(numArgs);
@@ -905,12 +4034,19 @@ DllPublic JSObject* CDecl ConstructJSFunctionCreate(JSContext* context, JSFuncti
 		for (int i = 0; i < numArgs; ++i)
 			unwrappedArgs[i] = Unwrap(context->Isolate, args[i]);
 
-		return new JSObject(
-			context->Isolate,
-			FromJust(context, tryCatch, function->LocalHandle(context)->NewInstance(
+		v8::Local<v8::Object> instance;
+		if (!ToLocalOrCaught(
+			context,
+			tryCatch,
+			function->LocalHandle(context)->NewInstance(
 				context->LocalHandle(),
 				numArgs,
-				data_ptr(unwrappedArgs))));
+				data_ptr(unwrappedArgs)),
+			&instance))
+		{
+			return static_cast<JSObject*>(nullptr);
+		}
+		return NewCachedWrapper<JSObject>(context, JSType::Object, instance);
 	});
 }
 
@@ -918,7 +4054,7 @@ DllPublic JSValue* CDecl JSFunctionAsValue(JSFunction* fun) { return static_cast
 
 // -------------------------------------------------------------------------
 // External
-DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value)
+DllPublic JSExternal* CDecl CreateSizedJSExternal(JSContext* context, void* value, int64_t size)
 {
 	V8Scope scope(context);
 
@@ -929,10 +4065,13 @@ DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value)
 		ResettingPersistent<v8::External> finalizer;
 		JSExternalFinalizer externalFinalizer;
 		void* value;
+		int64_t size;
 	};
 
-	auto closure = new Closure{{}, context->ExternalFinalizer, value};
+	auto closure = new Closure{{}, context->ExternalFinalizer, value, size};
 	closure->finalizer.Reset(context->Isolate, localExternal);
+	if (size != 0)
+		context->Isolate->AdjustAmountOfExternalAllocatedMemory(size);
 
 	closure->finalizer.SetWeak(
 		closure,
@@ -941,6 +4080,8 @@ DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value)
 			auto closure = data.GetParameter();
 			if (closure->externalFinalizer != nullptr)
 				closure->externalFinalizer(closure->value);
+			if (closure->size != 0)
+				data.GetIsolate()->AdjustAmountOfExternalAllocatedMemory(-closure->size);
 			closure->finalizer.Reset();
 			delete closure;
 		},
@@ -949,6 +4090,11 @@ DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value)
 	return new JSExternal(context->Isolate, localExternal);
 }
 
+DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value)
+{
+	return CreateSizedJSExternal(context, value, 0);
+}
+
 DllPublic void* CDecl GetJSExternalValue(JSContext* context, JSExternal* external)
 {
 	V8Scope scope(context);
@@ -962,23 +4108,532 @@ DllPublic JSValue* CDecl JSExternalAsValue(JSExternal* external) { return static
 DllPublic void CDecl RetainJSScriptException(JSContext* context, JSScriptException* e)
 {
 	if (e != nullptr)
-	{
-		v8::Locker(context->Isolate);
 		e->Retain();
-	}
 }
 DllPublic void CDecl ReleaseJSScriptException(JSContext* context, JSScriptException* e)
 {
 	if (e != nullptr)
 	{
-		v8::Locker(context->Isolate);
-		e->Release();
+		// Resets the exception's handles
+		ReleaseFromAnyThread(context, e);
+	}
+}
+
+// Makes *cached from the exception the first time it's asked for. produce
+// returns an empty handle for the empty string. cached is only read under
+// the lock, since two threads may ask for it at once.
+template<typename T>
+static JSString* LazyExceptionString(JSScriptException* e, JSString*& cached, T produce)
+{
+	auto context = e->Context;
+	V8Scope scope(context);
+	if (cached == nullptr)
+	{
+		v8::TryCatch tryCatch;
+		v8::Local<v8::String> str;
+		if (!produce(context->LocalHandle()).ToLocal(&str))
+			str = v8::String::Empty(context->Isolate);
+		cached = new JSString(context->Isolate, str);
+	}
+	return cached;
+}
+
+DllPublic JSValue* CDecl GetJSScriptException(JSScriptException* e)
+{
+	V8Scope scope(e->Context);
+	if (!e->ExceptionWrapped)
+	{
+		if (!e->ExceptionHandle.IsEmpty())
+			e->Exception = Wrap(e->Context, e->ExceptionHandle.Get(e->Context->Isolate));
+		e->ExceptionWrapped = true;
+	}
+	return e->Exception;
+}
+DllPublic JSString* CDecl GetJSScriptExceptionMessage(JSScriptException* e)
+{
+	return LazyExceptionString(e, e->ErrorMessage, [&] (v8::Local<v8::Context>) -> v8::MaybeLocal<v8::String>
+	{
+		if (e->Kind == JSScriptExceptionKind::Terminated)
+			return v8::String::NewFromUtf8(e->Context->Isolate, "Script execution was terminated", v8::NewStringType::kNormal);
+		if (e->MessageHandle.IsEmpty())
+			return v8::MaybeLocal<v8::String>();
+		return e->MessageHandle.Get(e->Context->Isolate)->Get();
+	});
+}
+DllPublic JSString* CDecl GetJSScriptExceptionFileName(JSScriptException* e)
+{
+	return LazyExceptionString(e, e->FileName, [&] (v8::Local<v8::Context> localContext) -> v8::MaybeLocal<v8::String>
+	{
+		if (e->MessageHandle.IsEmpty())
+			return v8::MaybeLocal<v8::String>();
+		return e->MessageHandle.Get(e->Context->Isolate)->GetScriptResourceName()->ToString(localContext);
+	});
+}
+DllPublic int CDecl GetJSScriptExceptionLineNumber(JSScriptException* e)
+{
+	if (e->MessageHandle.IsEmpty())
+		return -1;
+	V8Scope scope(e->Context);
+	return e->MessageHandle.Get(e->Context->Isolate)->GetLineNumber(e->Context->LocalHandle()).FromMaybe(-1);
+}
+DllPublic JSScriptExceptionKind CDecl GetJSScriptExceptionKind(JSScriptException* e) { return e->Kind; }
+DllPublic JSString* CDecl GetJSScriptExceptionStackTrace(JSScriptException* e)
+{
+	// Reads the stack property like v8::TryCatch::StackTrace
+	return LazyExceptionString(e, e->StackTrace, [&] (v8::Local<v8::Context> localContext) -> v8::MaybeLocal<v8::String>
+	{
+		if (e->ExceptionHandle.IsEmpty())
+			return v8::MaybeLocal<v8::String>();
+		auto exception = e->ExceptionHandle.Get(e->Context->Isolate);
+		if (!exception->IsObject())
+			return v8::MaybeLocal<v8::String>();
+		auto obj = exception.As<v8::Object>();
+		auto stackKey = v8::String::NewFromUtf8(e->Context->Isolate, "stack", v8::NewStringType::kInternalized).ToLocalChecked();
+		v8::Local<v8::Value> stack;
+		if (!obj->Has(localContext, stackKey).FromMaybe(false) || !obj->Get(localContext, stackKey).ToLocal(&stack))
+			return v8::MaybeLocal<v8::String>();
+		return stack->ToString(localContext);
+	});
+}
+DllPublic JSString* CDecl GetJSScriptExceptionSourceLine(JSScriptException* e)
+{
+	return LazyExceptionString(e, e->SourceLine, [&] (v8::Local<v8::Context> localContext) -> v8::MaybeLocal<v8::String>
+	{
+		if (e->MessageHandle.IsEmpty())
+			return v8::MaybeLocal<v8::String>();
+		return e->MessageHandle.Get(e->Context->Isolate)->GetSourceLine(localContext);
+	});
+}
+
+// -------------------------------------------------------------------------
+// Json
+static JSValue* ParseJson(JSContext* context, v8::TryCatch& tryCatch, v8::MaybeLocal<v8::String> json)
+{
+	return WrapResult(
+		context,
+		tryCatch,
+		v8::JSON::Parse(context->LocalHandle(), FromJust(context, tryCatch, json)));
+}
+
+DllPublic JSValue* CDecl ParseJSJson(JSContext* context, JSString* json, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return ParseJson(context, tryCatch, json->LocalHandle(context));
+	});
+}
+
+DllPublic JSValue* CDecl ParseJSJsonUtf16(JSContext* context, const uint16_t* buffer, int length, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return ParseJson(context, tryCatch, v8::String::NewFromTwoByte(context->Isolate, buffer, v8::NewStringType::kNormal, length));
+	});
+}
+
+DllPublic JSValue* CDecl ParseJSJsonUtf8(JSContext* context, const char* buffer, int length, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return ParseJson(context, tryCatch, v8::String::NewFromUtf8(context->Isolate, buffer, v8::NewStringType::kNormal, length));
+	});
+}
+
+// v8::JSON::Stringify only takes objects, so other values are stringified as
+// the only element of an array, without the brackets. Values that JSON can't
+// represent, like functions, give an empty string.
+static v8::Local<v8::String> Stringify(JSContext* context, const v8::TryCatch& tryCatch, JSValue* value, int indent)
+{
+	auto isolate = context->Isolate;
+	auto localContext = context->LocalHandle();
+	auto localValue = Unwrap(isolate, value);
+	v8::Local<v8::String> result;
+	if (localValue->IsObject())
+	{
+		v8::Local<v8::String> gap;
+		if (indent > 0)
+		{
+			// Like JSON.stringify, which uses at most 10 spaces
+			std::string spaces(static_cast<size_t>(indent < 10 ? indent : 10), ' ');
+			gap = FromJust(context, tryCatch, v8::String::NewFromUtf8(isolate, spaces.c_str(), v8::NewStringType::kNormal));
+		}
+		result = FromJust(context, tryCatch, v8::JSON::Stringify(localContext, localValue.As<v8::Object>(), gap));
+		// V8 turns an undefined result, as for functions, into the string
+		// "undefined", which no JSON text is.
+		auto undefinedString = FromJust(context, tryCatch, v8::String::NewFromUtf8(isolate, "undefined", v8::NewStringType::kNormal));
+		if (result->StrictEquals(undefinedString))
+			return v8::String::Empty(isolate);
+		return result;
+	}
+
+	auto array = v8::Array::New(isolate, 1);
+	FromJust(context, tryCatch, array->Set(localContext, 0, localValue));
+	auto wrapped = FromJust(context, tryCatch, v8::JSON::Stringify(localContext, array));
+	auto length = wrapped->Length() - 2;
+	std::vector<uint16_t> chars(static_cast<size_t>(length));
+	wrapped->Write(&chars[0], 1, length, v8::String::NO_NULL_TERMINATION);
+	return FromJust(context, tryCatch, v8::String::NewFromTwoByte(isolate, &chars[0], v8::NewStringType::kNormal, length));
+}
+
+DllPublic JSString* CDecl StringifyJSValue(JSContext* context, JSValue* value, int indent, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return new JSString(context->Isolate, Stringify(context, tryCatch, value, indent));
+	});
+}
+
+DllPublic int CDecl StringifyJSValueUtf16(JSContext* context, JSValue* value, int indent, uint16_t* outBuffer, int bufferLength, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WriteUtf16(Stringify(context, tryCatch, value, indent), outBuffer, bufferLength);
+	});
+}
+
+DllPublic int CDecl StringifyJSValueUtf8(JSContext* context, JSValue* value, int indent, char* outBuffer, int bufferLength, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WriteUtf8(Stringify(context, tryCatch, value, indent), outBuffer, bufferLength);
+	});
+}
+
+// -------------------------------------------------------------------------
+// Serializer
+DllPublic void CDecl RetainJSSerializedValue(JSSerializedValue* value)
+{
+	if (value != nullptr)
+		value->Retain();
+}
+
+DllPublic void CDecl ReleaseJSSerializedValue(JSSerializedValue* value)
+{
+	if (value != nullptr)
+		value->Release();
+}
+
+DllPublic JSSerializedValue* CDecl SerializeJSValue(JSContext* context, JSValue* value, JSObject* const* transfer, int transferCount, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto isolate = context->Isolate;
+		std::vector<v8::Local<v8::ArrayBuffer>> buffers;
+		for (int i = 0; i < transferCount; ++i)
+		{
+			auto localObj = transfer[i]->LocalHandle(context);
+			// External buffers belong to whoever made them
+			if (!localObj->IsArrayBuffer()
+				|| localObj.As<v8::ArrayBuffer>()->IsExternal()
+				|| !localObj.As<v8::ArrayBuffer>()->IsNeuterable())
+			{
+				isolate->ThrowException(v8::Exception::TypeError(
+					v8::String::NewFromUtf8(isolate, "Only array buffers created by the context can be transferred", v8::NewStringType::kNormal).ToLocalChecked()));
+				return static_cast<JSSerializedValue*>(nullptr);
+			}
+			buffers.push_back(localObj.As<v8::ArrayBuffer>());
+		}
+
+		v8::ValueSerializer serializer(isolate);
+		serializer.WriteHeader();
+		for (size_t i = 0; i < buffers.size(); ++i)
+			serializer.TransferArrayBuffer(static_cast<uint32_t>(i), buffers[i]);
+		if (!serializer.WriteValue(context->LocalHandle(), Unwrap(isolate, value)).FromMaybe(false))
+		{
+			if (!tryCatch.HasCaught())
+				Throw(context, tryCatch);
+			return static_cast<JSSerializedValue*>(nullptr);
+		}
+
+		auto result = new JSSerializedValue();
+		result->Data = serializer.ReleaseBuffer();
+		// Only detached from script once serializing has succeeded
+		for (auto& buffer: buffers)
+		{
+			auto contents = buffer->Externalize();
+			buffer->Neuter();
+			result->Buffers.push_back(TransferredBuffer { contents.Data(), contents.ByteLength() });
+		}
+		result->Allocator = context->Allocator;
+		result->Allocator->Retain();
+		return result;
+	});
+}
+
+DllPublic JSValue* CDecl DeserializeJSValue(JSContext* context, JSSerializedValue* value, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		auto isolate = context->Isolate;
+		auto localContext = context->LocalHandle();
+		v8::ValueDeserializer deserializer(isolate, data_ptr(value->Data), value->Data.size());
+		if (!deserializer.ReadHeader(localContext).FromMaybe(false))
+		{
+			if (!tryCatch.HasCaught())
+				Throw(context, tryCatch);
+			return static_cast<JSValue*>(nullptr);
+		}
+
+		std::vector<TransferredBuffer> buffers;
+		{
+			std::lock_guard<std::mutex> lock(value->Mutex);
+			buffers.swap(value->Buffers);
+		}
+		for (size_t i = 0; i < buffers.size(); ++i)
+		{
+			auto& buffer = buffers[i];
+			v8::Local<v8::ArrayBuffer> localBuffer;
+			if (context->Allocator->CanFree(value->Allocator))
+			{
+				// Hands the memory to the receiving isolate without copying
+				localBuffer = v8::ArrayBuffer::New(isolate, buffer.Data, buffer.Length, v8::ArrayBufferCreationMode::kInternalized);
+				value->Allocator->Freed(buffer.Data, buffer.Length);
+				context->Allocator->Allocated(buffer.Data, buffer.Length);
+			}
+			else
+			{
+				localBuffer = v8::ArrayBuffer::New(isolate, buffer.Length);
+				if (buffer.Length > 0)
+					memcpy(localBuffer->GetContents().Data(), buffer.Data, buffer.Length);
+				value->Allocator->Free(buffer.Data, buffer.Length);
+			}
+			deserializer.TransferArrayBuffer(static_cast<uint32_t>(i), localBuffer);
+		}
+
+		return WrapResult(context, tryCatch, deserializer.ReadValue(localContext));
+	});
+}
+
+DllPublic JSSerializedValue* CDecl CreateJSSerializedValue(const uint8_t* data, int length)
+{
+	auto result = new JSSerializedValue();
+	result->Data.assign(data, data + length);
+	return result;
+}
+
+DllPublic int CDecl CopyJSSerializedValueData(JSSerializedValue* value, uint8_t* outBuffer, int bufferLength)
+{
+	auto length = static_cast<int>(value->Data.size());
+	if (outBuffer != nullptr && length > 0 && bufferLength >= length)
+		memcpy(outBuffer, data_ptr(value->Data), length);
+	return length;
+}
+
+// -------------------------------------------------------------------------
+// Promise
+DllPublic void CDecl RetainJSPromiseResolver(JSPromiseResolver* resolver)
+{
+	if (resolver != nullptr)
+		resolver->Retain();
+}
+
+DllPublic void CDecl ReleaseJSPromiseResolver(JSContext* context, JSPromiseResolver* resolver)
+{
+	if (resolver != nullptr)
+	{
+		// Resets the resolver's handle
+		ReleaseFromAnyThread(context, resolver);
+	}
+}
+
+DllPublic JSPromiseResolver* CDecl CreateJSPromiseResolver(JSContext* context, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return new JSPromiseResolver(
+			context->Isolate,
+			FromJust(context, tryCatch, v8::Promise::Resolver::New(context->LocalHandle())));
+	});
+}
+
+DllPublic JSObject* CDecl CopyJSPromiseResolverPromise(JSContext* context, JSPromiseResolver* resolver)
+{
+	V8Scope scope(context);
+	return static_cast<JSObject*>(Wrap(context, resolver->LocalHandle(context)->GetPromise()));
+}
+
+DllPublic void CDecl ResolveJSPromise(JSContext* context, JSPromiseResolver* resolver, JSValue* value, JSScriptException** outError)
+{
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		FromJust(context, tryCatch, resolver->LocalHandle(context)->Resolve(
+			context->LocalHandle(),
+			Unwrap(context->Isolate, value)));
+	});
+}
+
+DllPublic void CDecl RejectJSPromise(JSContext* context, JSPromiseResolver* resolver, JSValue* value, JSScriptException** outError)
+{
+	TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		FromJust(context, tryCatch, resolver->LocalHandle(context)->Reject(
+			context->LocalHandle(),
+			Unwrap(context->Isolate, value)));
+	});
+}
+
+DllPublic bool CDecl JSPromiseHasHandler(JSContext* context, JSObject* promise)
+{
+	V8Scope scope(context);
+	auto handle = promise->LocalHandle(context);
+	return handle->IsPromise() && handle.As<v8::Promise>()->HasHandler();
+}
+
+// -------------------------------------------------------------------------
+// Module
+static std::u16string ToU16String(v8::Local<v8::String> localString)
+{
+	std::u16string result(localString->Length(), u'\0');
+	WriteUtf16(localString, reinterpret_cast<uint16_t*>(&result[0]), static_cast<int>(result.size()));
+	return result;
+}
+
+static v8::MaybeLocal<v8::Value> ThrowModuleError(JSContext* context, const char* message, v8::Local<v8::String> name)
+{
+	auto isolate = context->Isolate;
+	auto localMessage = v8::String::NewFromUtf8(isolate, message, v8::NewStringType::kNormal).ToLocalChecked();
+	isolate->ThrowException(v8::Exception::Error(v8::String::Concat(localMessage, name)));
+	return v8::MaybeLocal<v8::Value>();
+}
+
+static void RequireCallback(const v8::FunctionCallbackInfo<v8::Value>& info);
+
+// Returns the exports of the module specifier refers to from the module
+// named referrer, compiling and running it first if it hasn't been. Returns
+// empty, with an exception pending in V8, if that fails.
+static v8::MaybeLocal<v8::Value> RequireModule(JSContext* context, v8::Local<v8::String> specifier, v8::Local<v8::String> referrer)
+{
+	auto isolate = context->Isolate;
+	auto localContext = context->LocalHandle();
+	if (context->ModuleResolver == nullptr)
+		return ThrowModuleError(context, "No module loader to require ", specifier);
+
+	auto specifierString = new JSString(isolate, specifier);
+	auto referrerString = new JSString(isolate, referrer);
+	auto resolved = context->ModuleResolver(context, context->ModuleLoaderData, specifierString, referrerString);
+	referrerString->Release();
+	specifierString->Release();
+	if (resolved == nullptr)
+		return ThrowModuleError(context, "Cannot find module ", specifier);
+	auto fileName = resolved->LocalHandle(context);
+	resolved->Release();
+
+	auto exportsKey = v8::String::NewFromUtf8(isolate, "exports", v8::NewStringType::kInternalized).ToLocalChecked();
+	auto key = ToU16String(fileName);
+	auto it = context->Modules.find(key);
+	JSModule* module;
+	if (it != context->Modules.end())
+	{
+		module = it->second;
+		if (!module->Module.IsEmpty())
+			return module->Module.Get(isolate)->Get(localContext, exportsKey);
+	}
+	else
+	{
+		const uint8_t* cacheData = nullptr;
+		int cacheLength = 0;
+		auto fileNameString = new JSString(isolate, fileName);
+		auto code = context->ModuleLoader == nullptr
+			? nullptr
+			: context->ModuleLoader(context, context->ModuleLoaderData, fileNameString, &cacheData, &cacheLength);
+		fileNameString->Release();
+		if (code == nullptr)
+			return ThrowModuleError(context, "Cannot load module ", fileName);
+
+		// Keeps the module's code on its first line, so positions in it are
+		// only off by the wrapper's length on that line
+		auto wrapped = v8::String::Concat(
+			v8::String::Concat(
+				v8::String::NewFromUtf8(isolate, "(function (exports, require, module, __filename) {", v8::NewStringType::kNormal).ToLocalChecked(),
+				code->LocalHandle(context)),
+			v8::String::NewFromUtf8(isolate, "\n})", v8::NewStringType::kNormal).ToLocalChecked());
+		code->Release();
+
+		bool cacheRejected;
+		auto script = CompileScript(context, fileName, wrapped, cacheData, cacheLength, &cacheRejected);
+		if (script == nullptr)
+			return v8::MaybeLocal<v8::Value>();
+		module = new JSModule(script);
+		context->Modules.emplace(std::move(key), module);
+	}
+
+	auto moduleObject = v8::Object::New(isolate);
+	auto exports = v8::Object::New(isolate);
+	v8::Local<v8::Value> function;
+	v8::Local<v8::Function> require;
+	if (!moduleObject->Set(localContext, exportsKey, exports).FromMaybe(false)
+		|| !module->Script->LocalHandle(context)->BindToCurrentContext()->Run(localContext).ToLocal(&function)
+		|| !v8::Function::New(localContext, RequireCallback, fileName, 1).ToLocal(&require))
+	{
+		return v8::MaybeLocal<v8::Value>();
+	}
+	if (!function->IsFunction())
+		return ThrowModuleError(context, "Invalid module ", fileName);
+
+	// Set before running, so that modules requiring each other get the
+	// exports as far as they've got
+	module->Module.Reset(isolate, moduleObject);
+	v8::Local<v8::Value> args[] = { exports, require, moduleObject, fileName };
+	if (function.As<v8::Function>()->Call(localContext, v8::Undefined(isolate), 4, args).IsEmpty())
+	{
+		module->Module.Reset();
+		return v8::MaybeLocal<v8::Value>();
+	}
+	return moduleObject->Get(localContext, exportsKey);
+}
+
+static void RequireCallback(const v8::FunctionCallbackInfo<v8::Value>& info)
+{
+	auto isolate = info.GetIsolate();
+	auto context = static_cast<JSContext*>(isolate->GetData(0));
+	if (info.Length() < 1 || !info[0]->IsString())
+	{
+		isolate->ThrowException(v8::Exception::TypeError(
+			v8::String::NewFromUtf8(isolate, "require takes a module name", v8::NewStringType::kNormal).ToLocalChecked()));
+		return;
+	}
+	v8::Local<v8::Value> exports;
+	if (RequireModule(context, info[0].As<v8::String>(), info.Data().As<v8::String>()).ToLocal(&exports))
+		info.GetReturnValue().Set(exports);
+}
+
+DllPublic void CDecl SetJSModuleLoader(JSContext* context, void* data, JSModuleResolver resolver, JSModuleLoader loader)
+{
+	IsolateEntry entry(context->Isolate);
+	auto oldData = context->ModuleLoaderData;
+	// Without a resolver there's no loader to keep data for
+	auto newData = resolver == nullptr ? nullptr : data;
+	context->ModuleResolver = resolver;
+	context->ModuleLoader = loader;
+	context->ModuleLoaderData = newData;
+	context->ClearModules();
+	if (context->ExternalFinalizer != nullptr)
+	{
+		if (oldData != nullptr && oldData != newData)
+			context->ExternalFinalizer(oldData);
+		if (data != nullptr && data != newData && data != oldData)
+			context->ExternalFinalizer(data);
 	}
 }
-DllPublic JSValue* CDecl GetJSScriptException(JSScriptException* e) { return e->Exception; }
-DllPublic JSString* CDecl GetJSScriptExceptionMessage(JSScriptException* e) { return e->ErrorMessage; }
-DllPublic JSString* CDecl GetJSScriptExceptionFileName(JSScriptException* e) { return e->FileName; }
-DllPublic int CDecl GetJSScriptExceptionLineNumber(JSScriptException* e) { return e->LineNumber; }
-DllPublic JSString* CDecl GetJSScriptExceptionStackTrace(JSScriptException* e) { return e->StackTrace; }
-DllPublic JSString* CDecl GetJSScriptExceptionSourceLine(JSScriptException* e) { return e->SourceLine; }
+
+DllPublic JSValue* CDecl RequireJSModule(JSContext* context, JSString* specifier, JSScriptException** outError)
+{
+	return TryCatch(outError, context, [&] (v8::TryCatch& tryCatch)
+	{
+		return WrapResult(
+			context,
+			tryCatch,
+			RequireModule(context, specifier->LocalHandle(context), v8::String::Empty(context->Isolate)));
+	});
+}
+
+DllPublic JSScript* CDecl CopyJSModuleScript(JSContext* context, JSString* fileName)
+{
+	V8Scope scope(context);
+	auto it = context->Modules.find(ToU16String(fileName->LocalHandle(context)));
+	if (it == context->Modules.end())
+		return nullptr;
+	it->second->Script->Retain();
+	return it->second->Script;
+}
 /// }
@@ -16,6 +16,7 @@ public enum JSType
 	Array,
 	Function,
 	External,
+	Promise,
 }
 public enum JSRuntimeError
 {
@@ -23,6 +24,61 @@ public enum JSRuntimeError
 	InvalidCast,
 	StringTooLong,
 	TypeError,
+	ScriptError,
+	RangeError,
+}
+public enum JSGCType
+{
+	Scavenge = 1,
+	MarkSweepCompact = 2,
+	IncrementalMarking = 4,
+	ProcessWeakCallbacks = 8,
+}
+public enum JSScriptExceptionKind
+{
+	Exception,
+	Terminated,
+}
+public enum JSMemoryPressureLevel
+{
+	None,
+	Moderate,
+	Critical,
+}
+public enum JSMicrotasksPolicy
+{
+	Auto,
+	Explicit,
+}
+public enum JSArrayBufferAllocatorKind
+{
+	Default,
+	Pooled,
+}
+public enum JSTypedArrayType
+{
+	Int8,
+	Uint8,
+	Uint8Clamped,
+	Int16,
+	Uint16,
+	Int32,
+	Uint32,
+	Float32,
+	Float64,
+}
+public enum JSInstrumentedCall
+{
+	Evaluate,
+	RunScript,
+	CallFunction,
+	ConstructFunction,
+	CopyProperty,
+	SetProperty,
+	Callback,
+	FastCallback,
+	Wrap,
+	Unwrap,
 }
 [StructLayout(LayoutKind.Sequential)]
 public struct JSContext
@@ -33,6 +89,9 @@ public struct JSContext
 public struct JSValue
 {
 	readonly IntPtr _handle;
+	JSValue(IntPtr handle) { _handle = handle; }
+	// Reads argument index from the args of a JSFastCallback
+	public static JSValue ReadArg(IntPtr args, int index) { return new JSValue(Marshal.ReadIntPtr(args, index * IntPtr.Size)); }
 }
 [StructLayout(LayoutKind.Sequential)]
 public struct JSString
@@ -68,22 +127,186 @@ public struct JSScriptException
 	public static bool operator ==(JSScriptException e1, JSScriptException e2) { return e1._handle == e2._handle; }
 	public static bool operator !=(JSScriptException e1, JSScriptException e2) { return e1._handle != e2._handle; }
 }
+[StructLayout(LayoutKind.Sequential)]
+public struct JSScript
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSClass
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSSnapshot
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSSerializedValue
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSProfile
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSAsyncResult
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSPromiseResolver
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSContextPool
+{
+	readonly IntPtr _handle;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSContextPoolStatistics
+{
+	public int Hits;
+	public int Misses;
+	public int LiveIsolates;
+	public int IdleIsolates;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSTypedArrayInfo
+{
+	public JSTypedArrayType Type;
+	public int Length;
+	public int ByteOffset;
+	public int ByteLength;
+	public IntPtr Data;
+}
+public delegate void JSOOMErrorHandler(IntPtr location, [MarshalAs(UnmanagedType.I1)]bool isHeapOOM);
+public delegate void JSNearHeapLimitHandler(JSContext context, IntPtr data, long usedHeapSize, long heapSizeLimit);
+[StructLayout(LayoutKind.Sequential)]
+public struct JSContextOptions
+{
+	public int MaxSemiSpaceSize;
+	public int MaxOldSpaceSize;
+	public int CodeRangeSize;
+	public int StackSize;
+	[MarshalAs(UnmanagedType.FunctionPtr)] public JSOOMErrorHandler OOMErrorHandler;
+	[MarshalAs(UnmanagedType.FunctionPtr)] public JSNearHeapLimitHandler NearHeapLimitHandler;
+	public IntPtr NearHeapLimitHandlerData;
+	// Percentage of the heap size limit, 90 if 0
+	public int NearHeapLimitPercent;
+	public JSArrayBufferAllocatorKind ArrayBufferAllocator;
+	// Freed small buffers kept for reuse by the pooled allocator, 1024 if 0
+	public int ArrayBufferPoolSize;
+	// Buffers at least this big are mapped from the OS, never if 0
+	public int LargeArrayBufferSize;
+	// Keeps the context locked by the creating thread, which then has to
+	// make all calls to it, including the final release
+	[MarshalAs(UnmanagedType.I1)] public bool SingleThreaded;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSArrayBufferStatistics
+{
+	public long AllocationCount;
+	public long FreeCount;
+	public long AllocatedBytes;
+	public long PoolHitCount;
+	public long PooledBytes;
+	public long LargeAllocationCount;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSHeapStatistics
+{
+	public long TotalHeapSize;
+	public long TotalHeapSizeExecutable;
+	public long TotalPhysicalSize;
+	public long TotalAvailableSize;
+	public long UsedHeapSize;
+	public long HeapSizeLimit;
+	public long MallocedMemory;
+	public long PeakMallocedMemory;
+	public long ExternalMemory;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSHeapSpaceStatistics
+{
+	public IntPtr Name;
+	public long SpaceSize;
+	public long SpaceUsedSize;
+	public long SpaceAvailableSize;
+	public long PhysicalSpaceSize;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSCallCounter
+{
+	public long Calls;
+	public long Nanoseconds;
+}
+[StructLayout(LayoutKind.Sequential)]
+public struct JSObjectCounters
+{
+	public long WrapperAllocations;
+	public long LiveObjects;
+}
 public delegate JSValue JSCallback(JSContext context, IntPtr data, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSValue[] args, int numArgs, out JSValue error);
+public delegate JSValue JSFastCallback(JSContext context, IntPtr data, IntPtr args, int numArgs, out JSValue error);
 public delegate void JSExternalFinalizer(IntPtr external);
 public delegate void JSCallbackFinalizer(IntPtr data);
 public delegate void JSDebugMessageHandler(IntPtr data, JSString message);
+public delegate void JSInterruptCallback(JSContext context, IntPtr data);
+public delegate void JSGCEventHandler(IntPtr data, JSGCType type, double pauseMilliseconds);
+public delegate void JSAsyncCallback(JSContext context, IntPtr data, JSAsyncResult result);
+public delegate JSString JSModuleResolver(JSContext context, IntPtr data, JSString specifier, JSString referrer);
+public delegate JSString JSModuleLoader(JSContext context, IntPtr data, JSString fileName, out IntPtr cacheData, out int cacheLength);
 // -------------------------------------------------------------------------
 // Context
 public static class Context
 {
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InitializeJSPlatform")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool InitializePlatform(int threadCount, [MarshalAs(UnmanagedType.LPStr)]string flags);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSContext")]
 public static extern void Retain(JSContext context);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSContext")]
 public static extern void Release(JSContext context);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContext")]
 public static extern JSContext Create([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextFromSnapshot")]
+public static extern JSContext CreateFromSnapshot([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]byte[] snapshotData, int snapshotLength);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextWithOptions")]
+public static extern JSContext CreateWithOptions([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer, ref JSContextOptions options);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PumpJSContextMessageLoop")]
+public static extern int PumpMessageLoop(JSContext context, int maxTasks);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSMicrotasksPolicy")]
+public static extern void SetMicrotasksPolicy(JSContext context, JSMicrotasksPolicy policy);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RunJSMicrotasks")]
+public static extern void RunMicrotasks(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="EnqueueJSMicrotask")]
+public static extern void EnqueueMicrotask(JSContext context, JSFunction microtask);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateCreate")]
 public static extern JSValue EvaluateCreate(JSContext context, JSString fileName, JSString code, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="BeginJSContextSession")]
+public static extern void BeginSession(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="EndJSContextSession")]
+public static extern void EndSession(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DrainJSContextReleases")]
+public static extern int DrainReleases(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextIdentityCacheEnabled")]
+public static extern void SetIdentityCacheEnabled(JSContext context, [MarshalAs(UnmanagedType.I1)]bool enabled);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextTimeout")]
+public static extern void SetTimeout(JSContext context, int milliseconds);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="TerminateJSExecution")]
+public static extern void TerminateExecution(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="IsJSExecutionTerminating")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool IsExecutionTerminating(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CancelJSTerminateExecution")]
+public static extern void CancelTerminateExecution(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RequestJSInterrupt")]
+public static extern void RequestInterrupt(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSInterruptCallback callback);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextCopyGlobalObject")]
 public static extern JSObject CopyGlobalObject(JSContext context);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetV8Version")]
@@ -91,6 +314,115 @@ public static extern IntPtr GetV8VersionPtr();
 public static string GetV8Version() { return Marshal.PtrToStringAnsi(GetV8VersionPtr()); }
 }
 // -------------------------------------------------------------------------
+// Async
+public static class Async
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StartJSContextExecutor")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool StartExecutor(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSAsyncResult")]
+public static extern void Retain(JSAsyncResult result);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSAsyncResult")]
+public static extern void Release(JSContext context, JSAsyncResult result);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateAsync")]
+public static extern JSAsyncResult EvaluateAsync(JSContext context, JSString fileName, JSString code, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSAsyncCallback callback);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CallJSFunctionAsync")]
+public static extern JSAsyncResult CallAsync(JSContext context, JSFunction function, JSObject thisObject, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSValue[] args, int numArgs, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSAsyncCallback callback);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="IsJSAsyncResultDone")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool IsDone(JSAsyncResult result);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WaitJSAsyncResult")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool Wait(JSAsyncResult result, int timeoutMilliseconds);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSAsyncResultValue")]
+public static extern JSValue CopyValue(JSAsyncResult result);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSAsyncResultError")]
+public static extern JSScriptException CopyError(JSAsyncResult result);
+}
+// -------------------------------------------------------------------------
+// Context pool
+public static class ContextPool
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSContextPool")]
+public static extern void Retain(JSContextPool pool);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSContextPool")]
+public static extern void Release(JSContextPool pool);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextPool")]
+public static extern JSContextPool Create(int maxIdleContexts, [MarshalAs(UnmanagedType.I1)]bool resetContexts, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AcquireJSContext")]
+public static extern JSContext Acquire(JSContextPool pool);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSContextToPool")]
+public static extern void ReleaseContext(JSContextPool pool, JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextPoolStatistics")]
+public static extern void GetStatistics(JSContextPool pool, out JSContextPoolStatistics statistics);
+}
+// -------------------------------------------------------------------------
+// Snapshot
+public static class Snapshot
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSnapshot")]
+public static extern void Retain(JSSnapshot snapshot);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSnapshot")]
+public static extern void Release(JSSnapshot snapshot);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshot")]
+public static extern JSSnapshot Create([In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr, SizeParamIndex = 2)]string[] sources, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]int[] sourceLengths, int numSources, out JSRuntimeError error);
+public static JSSnapshot Create(string[] sources, out JSRuntimeError error)
+{
+	var sourceLengths = new int[sources.Length];
+	for (int i = 0; i < sources.Length; ++i)
+		sourceLengths[i] = sources[i].Length;
+	return Create(sources, sourceLengths, sources.Length, out error);
+}
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSSnapshotData")]
+public static extern int CopyData(JSSnapshot snapshot, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+public static byte[] GetData(JSSnapshot snapshot)
+{
+	var buffer = new byte[CopyData(snapshot, null, 0)];
+	CopyData(snapshot, buffer, buffer.Length);
+	return buffer;
+}
+}
+// -------------------------------------------------------------------------
+// Script
+public static class Script
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSScript")]
+public static extern void Retain(JSContext context, JSScript script);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSScript")]
+public static extern void Release(JSContext context, JSScript script);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CompileJSScript")]
+public static extern JSScript Compile(JSContext context, JSString fileName, JSString code, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]byte[] cacheData, int cacheLength, [MarshalAs(UnmanagedType.I1)]out bool cacheRejected, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RunJSScript")]
+public static extern JSValue Run(JSContext context, JSScript script, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSScriptCodeCache")]
+public static extern int CopyCodeCache(JSScript script, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+public static byte[] GetCodeCache(JSScript script)
+{
+	var buffer = new byte[CopyCodeCache(script, null, 0)];
+	CopyCodeCache(script, buffer, buffer.Length);
+	return buffer;
+}
+}
+// -------------------------------------------------------------------------
+// Class
+public static class Class
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSClass")]
+public static extern void Retain(JSContext context, JSClass cls);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSClass")]
+public static extern void Release(JSContext context, JSClass cls);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSClass")]
+public static extern JSClass Create(JSContext context, JSString name);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AddJSClassMethod")]
+public static extern void AddMethod(JSContext context, JSClass cls, JSString name, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AddJSClassAccessor")]
+public static extern void AddAccessor(JSContext context, JSClass cls, JSString name, IntPtr getterData, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback getter, IntPtr setterData, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback setter, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSClassInstance")]
+public static extern JSObject CreateInstance(JSContext context, JSClass cls, IntPtr data, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSClassInstanceData")]
+public static extern IntPtr GetInstanceData(JSContext context, JSClass cls, JSObject obj, out JSRuntimeError error);
+}
+// -------------------------------------------------------------------------
 // Debug
 public static class Debug
 {
@@ -102,6 +434,64 @@ public static extern void SendCommand(JSContext context, [MarshalAs(UnmanagedTyp
 public static extern void ProcessMessages(JSContext context);
 }
 // -------------------------------------------------------------------------
+// Profiler
+public static class Profiler
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSProfile")]
+public static extern void Retain(JSProfile profile);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSProfile")]
+public static extern void Release(JSProfile profile);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSProfileData")]
+public static extern int CopyData(JSProfile profile, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StartJSCpuProfile")]
+public static extern void StartCpuProfile(JSContext context, JSString title, int samplingIntervalMicroseconds);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CollectJSCpuProfileSample")]
+public static extern void CollectCpuProfileSample(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StopJSCpuProfile")]
+public static extern JSProfile StopCpuProfile(JSContext context, JSString title);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="TakeJSHeapSnapshot")]
+public static extern JSProfile TakeHeapSnapshot(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSInstrumentationEnabled")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool SetInstrumentationEnabled([MarshalAs(UnmanagedType.I1)]bool enabled);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSCallCounter")]
+public static extern void GetCallCounter(JSInstrumentedCall call, out JSCallCounter counter);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectCounters")]
+public static extern void GetObjectCounters(out JSObjectCounters counters);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ResetJSInstrumentationCounters")]
+public static extern void ResetInstrumentationCounters();
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StartJSTracing")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool StartTracing([MarshalAs(UnmanagedType.LPStr)]string path, [MarshalAs(UnmanagedType.LPStr)]string categories);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StopJSTracing")]
+public static extern void StopTracing();
+}
+// -------------------------------------------------------------------------
+// Heap
+public static class Heap
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHeapStatistics")]
+public static extern void GetStatistics(JSContext context, out JSHeapStatistics statistics);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHeapSpaceCount")]
+public static extern int GetSpaceCount(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHeapSpaceStatistics")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool GetSpaceStatistics(JSContext context, int index, out JSHeapSpaceStatistics statistics);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSGCEventHandler")]
+public static extern void SetGCEventHandler(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSGCEventHandler handler);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSMemoryPressure")]
+public static extern void NotifyMemoryPressure(JSContext context, JSMemoryPressureLevel level);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSIdle")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool NotifyIdle(JSContext context, double idleMilliseconds);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSLowMemory")]
+public static extern void NotifyLowMemory(JSContext context);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextArrayBufferStatistics")]
+public static extern void GetArrayBufferStatistics(JSContext context, out JSArrayBufferStatistics statistics);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AdjustJSExternalMemory")]
+public static extern long AdjustExternalMemory(JSContext context, long changeInBytes);
+}
+// -------------------------------------------------------------------------
 // Value
 public static class Value
 {
@@ -143,21 +533,48 @@ public static extern JSValue CreateDouble(double value);
 public static extern JSValue CreateBool([MarshalAs(UnmanagedType.I1)]bool value);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSArrayBuffer")]
 public static extern JSObject CreateExternalArrayBuffer(JSContext context, IntPtr data, int byteLength);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateSizedExternalJSArrayBuffer")]
+public static extern JSObject CreateSizedExternalArrayBuffer(JSContext context, IntPtr data, int byteLength, IntPtr finalizerData, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSArrayBuffer")]
+public static extern JSObject CreateArrayBuffer(JSContext context, int byteLength, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSTypedArray")]
+public static extern JSObject CreateTypedArray(JSContext context, JSObject arrayBuffer, JSTypedArrayType type, int byteOffset, int length, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSCallback")]
 public static extern JSFunction CreateCallback(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSFastCallback")]
+public static extern JSFunction CreateFastCallback(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSFastCallback callback, out JSScriptException error);
 // --------------------------------------------------------------------------
 // String
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSString")]
 public static extern JSString CreateString(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string buffer, int length, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSPropertyKey")]
+public static extern JSString CreatePropertyKey(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string buffer, int length, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSString")]
+public static extern JSString CreateExternalString(JSContext context, IntPtr buffer, int length, IntPtr data, out JSRuntimeError error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalOneByteJSString")]
+public static extern JSString CreateExternalOneByteString(JSContext context, IntPtr buffer, int length, IntPtr data, out JSRuntimeError error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSStringLength")]
 public static extern int Length(JSContext context, JSString str);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStringBuffer")]
 public static extern void Write(JSContext context, JSString str, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode, EntryPoint="WriteJSStringUtf16")]
+public static extern int Write(JSContext context, JSString str, [Out] char[] buffer, int bufferLength);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStringUtf8")]
+public static extern int WriteUtf8(JSContext context, JSString str, [Out] byte[] buffer, int bufferLength);
+const int MaxCachedStringBufferLength = 64 * 1024;
+[ThreadStatic] static char[] _stringBuffer;
 public static string ToString(JSContext context, JSString str)
 {
-	var sb = new StringBuilder(Length(context, str) + 1);
-	Write(context, str, sb, true);
-	return sb.ToString();
+	var buffer = _stringBuffer ?? (_stringBuffer = new char[256]);
+	var length = Write(context, str, buffer, buffer.Length);
+	if (length > buffer.Length)
+	{
+		buffer = new char[length];
+		if (length <= MaxCachedStringBufferLength)
+			_stringBuffer = buffer;
+		length = Write(context, str, buffer, buffer.Length);
+	}
+	return new string(buffer, 0, length);
 }
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSStringAsValue")]
 public static extern JSValue AsValue(JSString str);
@@ -167,6 +584,10 @@ public static extern JSValue AsValue(JSString str);
 public static extern JSValue CopyProperty(JSContext context, JSObject obj, JSString key, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectProperty")]
 public static extern void SetProperty(JSContext context, JSObject obj, JSString key, JSValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectProperties")]
+public static extern void CopyProperties(JSContext context, JSObject obj, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSString[] keys, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSValue[] values, int count, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectProperties")]
+public static extern void SetProperties(JSContext context, JSObject obj, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSString[] keys, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSValue[] values, int count, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectOwnPropertyNames")]
 public static extern JSArray CopyOwnPropertyNames(JSContext context, JSObject obj, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSObjectHasProperty")]
@@ -174,6 +595,12 @@ public static extern JSArray CopyOwnPropertyNames(JSContext context, JSObject ob
 public static extern bool HasProperty(JSContext context, JSObject obj, JSString key, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectArrayBufferData")]
 public static extern IntPtr GetArrayBufferData(JSContext context, JSObject obj, out JSRuntimeError outError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectArrayBufferByteLength")]
+public static extern int GetArrayBufferByteLength(JSContext context, JSObject obj, out JSRuntimeError outError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectTypedArrayInfo")]
+public static extern void GetTypedArrayInfo(JSContext context, JSObject obj, out JSTypedArrayInfo info, out JSRuntimeError outError);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectTypedArrayBuffer")]
+public static extern JSObject CopyTypedArrayBuffer(JSContext context, JSObject obj, out JSRuntimeError outError);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSObjectAsValue")]
 public static extern JSValue AsValue(JSObject obj);
 // -------------------------------------------------------------------------
@@ -182,6 +609,10 @@ public static extern JSValue AsValue(JSObject obj);
 public static extern JSValue CopyProperty(JSContext context, JSArray arr, int index, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndex")]
 public static extern void SetProperty(JSContext context, JSArray arr, int index, JSValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSArrayRange")]
+public static extern void CopyRange(JSContext context, JSArray arr, int start, int count, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSValue[] values, out JSRuntimeError runtimeError, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayRange")]
+public static extern void SetRange(JSContext context, JSArray arr, int start, int count, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSValue[] values, out JSRuntimeError runtimeError, out JSScriptException error);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSArrayLength")]
 public static extern int Length(JSContext context, JSArray arr);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSArrayAsValue")]
@@ -198,6 +629,8 @@ public static extern JSValue AsValue(JSFunction fun);
 // External
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSExternal")]
 public static extern JSExternal CreateExternal(JSContext context, IntPtr value);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateSizedJSExternal")]
+public static extern JSExternal CreateSizedExternal(JSContext context, IntPtr value, long size);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSExternalValue")]
 public static extern IntPtr GetExternalValue(JSContext context, JSExternal external);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSExternalAsValue")]
@@ -219,9 +652,76 @@ public static extern JSString GetMessage(JSScriptException e);
 public static extern JSString GetFileName(JSScriptException e);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionLineNumber")]
 public static extern int GetLineNumber(JSScriptException e);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionKind")]
+public static extern JSScriptExceptionKind GetKind(JSScriptException e);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionStackTrace")]
 public static extern JSString GetStackTrace(JSScriptException e);
 [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionSourceLine")]
 public static extern JSString GetSourceLine(JSScriptException e);
 }
+// -------------------------------------------------------------------------
+// Json
+public static class Json
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ParseJSJson")]
+public static extern JSValue Parse(JSContext context, JSString json, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ParseJSJsonUtf16")]
+public static extern JSValue Parse(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string json, int length, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ParseJSJsonUtf8")]
+public static extern JSValue ParseUtf8(JSContext context, byte[] json, int length, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StringifyJSValue")]
+public static extern JSString Stringify(JSContext context, JSValue value, int indent, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode, EntryPoint="StringifyJSValueUtf16")]
+public static extern int Stringify(JSContext context, JSValue value, int indent, [Out] char[] buffer, int bufferLength, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StringifyJSValueUtf8")]
+public static extern int StringifyUtf8(JSContext context, JSValue value, int indent, [Out] byte[] buffer, int bufferLength, out JSScriptException error);
+}
+// -------------------------------------------------------------------------
+// Serializer
+public static class Serializer
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSerializedValue")]
+public static extern void Retain(JSSerializedValue value);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSerializedValue")]
+public static extern void Release(JSSerializedValue value);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SerializeJSValue")]
+public static extern JSSerializedValue Serialize(JSContext context, JSValue value, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSObject[] transfer, int transferCount, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DeserializeJSValue")]
+public static extern JSValue Deserialize(JSContext context, JSSerializedValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSerializedValue")]
+public static extern JSSerializedValue Create([In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 1)]byte[] data, int length);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSSerializedValueData")]
+public static extern int CopyData(JSSerializedValue value, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+}
+// -------------------------------------------------------------------------
+// Promise
+public static class Promise
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSPromiseResolver")]
+public static extern void Retain(JSPromiseResolver resolver);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSPromiseResolver")]
+public static extern void Release(JSContext context, JSPromiseResolver resolver);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSPromiseResolver")]
+public static extern JSPromiseResolver CreateResolver(JSContext context, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSPromiseResolverPromise")]
+public static extern JSObject CopyPromise(JSContext context, JSPromiseResolver resolver);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ResolveJSPromise")]
+public static extern void Resolve(JSContext context, JSPromiseResolver resolver, JSValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RejectJSPromise")]
+public static extern void Reject(JSContext context, JSPromiseResolver resolver, JSValue value, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSPromiseHasHandler")]
+[return: MarshalAs(UnmanagedType.I1)]
+public static extern bool HasHandler(JSContext context, JSObject promise);
+}
+// -------------------------------------------------------------------------
+// Module
+public static class Module
+{
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSModuleLoader")]
+public static extern void SetLoader(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSModuleResolver resolver, [MarshalAs(UnmanagedType.FunctionPtr)]JSModuleLoader loader);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RequireJSModule")]
+public static extern JSValue Require(JSContext context, JSString specifier, out JSScriptException error);
+[DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSModuleScript")]
+public static extern JSScript CopyScript(JSContext context, JSString fileName);
+}
 }
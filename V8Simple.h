@@ -34,7 +34,9 @@
 /// 	Array,
 /// 	Function,
 /// 	External,
+/// 	Promise,
 /// }
+///// Promises are JSObjects of type Promise
 enum class JSType
 {
 	Null,
@@ -46,6 +48,7 @@ enum class JSType
 	Array,
 	Function,
 	External,
+	Promise,
 };
 /// public enum JSRuntimeError
 /// {
@@ -53,6 +56,8 @@ enum class JSType
 /// 	InvalidCast,
 /// 	StringTooLong,
 /// 	TypeError,
+/// 	ScriptError,
+/// 	RangeError,
 /// }
 enum class JSRuntimeError
 {
@@ -60,6 +65,120 @@ enum class JSRuntimeError
 	InvalidCast,
 	StringTooLong,
 	TypeError,
+	ScriptError,
+	RangeError,
+};
+/// public enum JSGCType
+/// {
+/// 	Scavenge = 1,
+/// 	MarkSweepCompact = 2,
+/// 	IncrementalMarking = 4,
+/// 	ProcessWeakCallbacks = 8,
+/// }
+enum class JSGCType
+{
+	Scavenge = 1,
+	MarkSweepCompact = 2,
+	IncrementalMarking = 4,
+	ProcessWeakCallbacks = 8,
+};
+/// public enum JSScriptExceptionKind
+/// {
+/// 	Exception,
+/// 	Terminated,
+/// }
+enum class JSScriptExceptionKind
+{
+	Exception,
+	Terminated,
+};
+/// public enum JSMemoryPressureLevel
+/// {
+/// 	None,
+/// 	Moderate,
+/// 	Critical,
+/// }
+enum class JSMemoryPressureLevel
+{
+	None,
+	Moderate,
+	Critical,
+};
+///// Auto runs microtasks, such as promise reactions, whenever the outermost
+///// call into script returns. Explicit only runs them in RunMicrotasks.
+/// public enum JSMicrotasksPolicy
+/// {
+/// 	Auto,
+/// 	Explicit,
+/// }
+enum class JSMicrotasksPolicy
+{
+	Auto,
+	Explicit,
+};
+/// public enum JSArrayBufferAllocatorKind
+/// {
+/// 	Default,
+/// 	Pooled,
+/// }
+enum class JSArrayBufferAllocatorKind
+{
+	Default,
+	Pooled,
+};
+/// public enum JSTypedArrayType
+/// {
+/// 	Int8,
+/// 	Uint8,
+/// 	Uint8Clamped,
+/// 	Int16,
+/// 	Uint16,
+/// 	Int32,
+/// 	Uint32,
+/// 	Float32,
+/// 	Float64,
+/// }
+enum class JSTypedArrayType
+{
+	Int8,
+	Uint8,
+	Uint8Clamped,
+	Int16,
+	Uint16,
+	Int32,
+	Uint32,
+	Float32,
+	Float64,
+};
+///// The entry points and callbacks Profiler.GetCallCounter reports on. Wrap
+///// and Unwrap, the conversions between JSValues and V8 values, are counted
+///// but not timed.
+/// public enum JSInstrumentedCall
+/// {
+/// 	Evaluate,
+/// 	RunScript,
+/// 	CallFunction,
+/// 	ConstructFunction,
+/// 	CopyProperty,
+/// 	SetProperty,
+/// 	Callback,
+/// 	FastCallback,
+/// 	Wrap,
+/// 	Unwrap,
+/// }
+enum class JSInstrumentedCall
+{
+	Evaluate,
+	RunScript,
+	CallFunction,
+	ConstructFunction,
+	CopyProperty,
+	SetProperty,
+	Callback,
+	FastCallback,
+	Wrap,
+	Unwrap,
+	Count,
 };
 /// [StructLayout(LayoutKind.Sequential)]
 /// public struct JSContext
@@ -71,6 +190,9 @@ struct JSContext;
 /// public struct JSValue
 /// {
 /// 	readonly IntPtr _handle;
+/// 	JSValue(IntPtr handle) { _handle = handle; }
+/// 	// Reads argument index from the args of a JSFastCallback
+/// 	public static JSValue ReadArg(IntPtr args, int index) { return new JSValue(Marshal.ReadIntPtr(args, index * IntPtr.Size)); }
 /// }
 struct JSValue;
 /// [StructLayout(LayoutKind.Sequential)]
@@ -113,19 +235,275 @@ struct JSExternal;
 /// 	public static bool operator !=(JSScriptException e1, JSScriptException e2) { return e1._handle != e2._handle; }
 /// }
 struct JSScriptException;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSScript
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSScript;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSClass
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSClass;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSSnapshot
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSSnapshot;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSSerializedValue
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSSerializedValue;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSProfile
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSProfile;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSAsyncResult
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSAsyncResult;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSPromiseResolver
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSPromiseResolver;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSContextPool
+/// {
+/// 	readonly IntPtr _handle;
+/// }
+struct JSContextPool;
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSContextPoolStatistics
+/// {
+/// 	public int Hits;
+/// 	public int Misses;
+/// 	public int LiveIsolates;
+/// 	public int IdleIsolates;
+/// }
+struct JSContextPoolStatistics
+{
+	int Hits;
+	int Misses;
+	int LiveIsolates;
+	int IdleIsolates;
+};
+///// Data points into the underlying ArrayBuffer at ByteOffset and is valid
+///// for as long as the typed array's buffer is alive.
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSTypedArrayInfo
+/// {
+/// 	public JSTypedArrayType Type;
+/// 	public int Length;
+/// 	public int ByteOffset;
+/// 	public int ByteLength;
+/// 	public IntPtr Data;
+/// }
+struct JSTypedArrayInfo
+{
+	JSTypedArrayType Type;
+	int Length;
+	int ByteOffset;
+	int ByteLength;
+	void* Data;
+};
+///// Called when V8 runs out of memory. V8 can't be used at all afterwards;
+///// this is the chance to log the failure before the process goes down.
+/// public delegate void JSOOMErrorHandler(IntPtr location, [MarshalAs(UnmanagedType.I1)]bool isHeapOOM);
+typedef void (StdCall *JSOOMErrorHandler)(const char* location, bool isHeapOOM);
+///// Called after a garbage collection that leaves the heap above the
+///// context's near heap limit, e.g. to terminate the script that fills it.
+///// Not called again until the heap has dropped below the limit.
+/// public delegate void JSNearHeapLimitHandler(JSContext context, IntPtr data, long usedHeapSize, long heapSizeLimit);
+typedef void (StdCall *JSNearHeapLimitHandler)(JSContext* context, void* data, int64_t usedHeapSize, int64_t heapSizeLimit);
+///// Heap sizes are in megabytes. StackSize counts from where the context is
+///// created, and on other threads, such as the executor, from where they
+///// call into the context; it and the array buffer sizes are in
+///// kilobytes. Leave a field at 0 for the default.
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSContextOptions
+/// {
+/// 	public int MaxSemiSpaceSize;
+/// 	public int MaxOldSpaceSize;
+/// 	public int CodeRangeSize;
+/// 	public int StackSize;
+/// 	[MarshalAs(UnmanagedType.FunctionPtr)] public JSOOMErrorHandler OOMErrorHandler;
+/// 	[MarshalAs(UnmanagedType.FunctionPtr)] public JSNearHeapLimitHandler NearHeapLimitHandler;
+/// 	public IntPtr NearHeapLimitHandlerData;
+/// 	// Percentage of the heap size limit, 90 if 0
+/// 	public int NearHeapLimitPercent;
+/// 	public JSArrayBufferAllocatorKind ArrayBufferAllocator;
+/// 	// Freed small buffers kept for reuse by the pooled allocator, 1024 if 0
+/// 	public int ArrayBufferPoolSize;
+/// 	// Buffers at least this big are mapped from the OS, never if 0
+/// 	public int LargeArrayBufferSize;
+/// 	// Keeps the context locked by the creating thread, which then has to
+/// 	// make all calls to it, including the final release
+/// 	[MarshalAs(UnmanagedType.I1)] public bool SingleThreaded;
+/// }
+struct JSContextOptions
+{
+	int MaxSemiSpaceSize;
+	int MaxOldSpaceSize;
+	int CodeRangeSize;
+	int StackSize;
+	JSOOMErrorHandler OOMErrorHandler;
+	JSNearHeapLimitHandler NearHeapLimitHandler;
+	void* NearHeapLimitHandlerData;
+	int NearHeapLimitPercent;
+	JSArrayBufferAllocatorKind ArrayBufferAllocator;
+	int ArrayBufferPoolSize;
+	int LargeArrayBufferSize;
+	bool SingleThreaded;
+};
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSArrayBufferStatistics
+/// {
+/// 	public long AllocationCount;
+/// 	public long FreeCount;
+/// 	public long AllocatedBytes;
+/// 	public long PoolHitCount;
+/// 	public long PooledBytes;
+/// 	public long LargeAllocationCount;
+/// }
+struct JSArrayBufferStatistics
+{
+	int64_t AllocationCount;
+	int64_t FreeCount;
+	int64_t AllocatedBytes;
+	int64_t PoolHitCount;
+	int64_t PooledBytes;
+	int64_t LargeAllocationCount;
+};
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSHeapStatistics
+/// {
+/// 	public long TotalHeapSize;
+/// 	public long TotalHeapSizeExecutable;
+/// 	public long TotalPhysicalSize;
+/// 	public long TotalAvailableSize;
+/// 	public long UsedHeapSize;
+/// 	public long HeapSizeLimit;
+/// 	public long MallocedMemory;
+/// 	public long PeakMallocedMemory;
+/// 	public long ExternalMemory;
+/// }
+struct JSHeapStatistics
+{
+	int64_t TotalHeapSize;
+	int64_t TotalHeapSizeExecutable;
+	int64_t TotalPhysicalSize;
+	int64_t TotalAvailableSize;
+	int64_t UsedHeapSize;
+	int64_t HeapSizeLimit;
+	int64_t MallocedMemory;
+	int64_t PeakMallocedMemory;
+	int64_t ExternalMemory;
+};
+///// Name points to a string owned by V8
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSHeapSpaceStatistics
+/// {
+/// 	public IntPtr Name;
+/// 	public long SpaceSize;
+/// 	public long SpaceUsedSize;
+/// 	public long SpaceAvailableSize;
+/// 	public long PhysicalSpaceSize;
+/// }
+struct JSHeapSpaceStatistics
+{
+	const char* Name;
+	int64_t SpaceSize;
+	int64_t SpaceUsedSize;
+	int64_t SpaceAvailableSize;
+	int64_t PhysicalSpaceSize;
+};
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSCallCounter
+/// {
+/// 	public long Calls;
+/// 	public long Nanoseconds;
+/// }
+struct JSCallCounter
+{
+	int64_t Calls;
+	int64_t Nanoseconds;
+};
+///// WrapperAllocations counts the JSValues allocated while instrumentation
+///// is enabled. LiveObjects is the number of reference counted objects
+///// (values, scripts, exceptions, snapshots, ...) alive right now.
+/// [StructLayout(LayoutKind.Sequential)]
+/// public struct JSObjectCounters
+/// {
+/// 	public long WrapperAllocations;
+/// 	public long LiveObjects;
+/// }
+struct JSObjectCounters
+{
+	int64_t WrapperAllocations;
+	int64_t LiveObjects;
+};
 /// public delegate JSValue JSCallback(JSContext context, IntPtr data, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSValue[] args, int numArgs, out JSValue error);
 typedef JSValue* (StdCall *JSCallback)(JSContext* context, void* data, JSValue* const* args, int numArgs, JSValue** outError);
+///// Like JSCallback, but args is passed as a raw pointer so that calls don't
+///// allocate an array; read it with JSValue.ReadArg. The args are only valid
+///// during the call.
+/// public delegate JSValue JSFastCallback(JSContext context, IntPtr data, IntPtr args, int numArgs, out JSValue error);
+typedef JSValue* (StdCall *JSFastCallback)(JSContext* context, void* data, JSValue* const* args, int numArgs, JSValue** outError);
 /// public delegate void JSExternalFinalizer(IntPtr external);
 typedef void (StdCall *JSExternalFinalizer)(void* external);
 /// public delegate void JSCallbackFinalizer(IntPtr data);
 typedef void (StdCall *JSCallbackFinalizer)(void* data);
 /// public delegate void JSDebugMessageHandler(IntPtr data, JSString message);
 typedef void (StdCall *JSDebugMessageHandler)(void* data, JSString* message);
+///// Called on the thread running script, with the isolate locked
+/// public delegate void JSInterruptCallback(JSContext context, IntPtr data);
+typedef void (StdCall *JSInterruptCallback)(JSContext* context, void* data);
+///// Called after each garbage collection, with the time the collection took.
+///// Must not call into the context.
+/// public delegate void JSGCEventHandler(IntPtr data, JSGCType type, double pauseMilliseconds);
+typedef void (StdCall *JSGCEventHandler)(void* data, JSGCType type, double pauseMilliseconds);
+///// Called on the context's executor thread, with the isolate locked, when an
+///// asynchronous call has completed. result is only valid during the call
+///// unless retained. The result is done before the callback is called, so
+///// Async.Wait may return while the callback is still running.
+/// public delegate void JSAsyncCallback(JSContext context, IntPtr data, JSAsyncResult result);
+typedef void (StdCall *JSAsyncCallback)(JSContext* context, void* data, JSAsyncResult* result);
+///// Returns the file name of the module that specifier refers to when
+///// required from the module named referrer, which is empty at the top
+///// level. Returns null if there's no such module. The file name keys the
+///// compiled module, so equal names must mean the same file.
+/// public delegate JSString JSModuleResolver(JSContext context, IntPtr data, JSString specifier, JSString referrer);
+typedef JSString* (StdCall *JSModuleResolver)(JSContext* context, void* data, JSString* specifier, JSString* referrer);
+///// Returns the code of the module at fileName, or null if it can't be read.
+///// Only called the first time the module is required. May also return a
+///// code cache from Script.CopyCodeCache for the module, which must stay
+///// valid until the require that called the loader returns.
+/// public delegate JSString JSModuleLoader(JSContext context, IntPtr data, JSString fileName, out IntPtr cacheData, out int cacheLength);
+typedef JSString* (StdCall *JSModuleLoader)(JSContext* context, void* data, JSString* fileName, const uint8_t** outCacheData, int* outCacheLength);
 
 /// // -------------------------------------------------------------------------
 /// // Context
 /// public static class Context
 /// {
+///// Initializes V8 with threadCount background threads for GC and
+///// compilation (one less than the number of cores if 0) and the given V8
+///// command line flags, which may be null. Must be called before the first
+///// context is created, otherwise it does nothing and returns false.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="InitializeJSPlatform")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool InitializePlatform(int threadCount, [MarshalAs(UnmanagedType.LPStr)]string flags);
+DllPublic bool CDecl InitializeJSPlatform(int threadCount, const char* flags);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSContext")]
 /// public static extern void Retain(JSContext context);
 DllPublic void CDecl RetainJSContext(JSContext* context);
@@ -135,9 +513,87 @@ DllPublic void CDecl ReleaseJSContext(JSContext* context);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContext")]
 /// public static extern JSContext Create([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
 DllPublic JSContext* CDecl CreateJSContext(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer);
+///// Creates a context whose isolate starts from a blob produced by
+///// Snapshot.Create, so the scripts evaluated into the snapshot don't have to
+///// be evaluated again. The blob is copied.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextFromSnapshot")]
+/// public static extern JSContext CreateFromSnapshot([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]byte[] snapshotData, int snapshotLength);
+DllPublic JSContext* CDecl CreateJSContextFromSnapshot(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer, const uint8_t* snapshotData, int snapshotLength);
+///// Creates a context whose isolate has the given heap limits and memory
+///// handlers. NearHeapLimitHandlerData is passed to the external finalizer
+///// when the context is destroyed.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextWithOptions")]
+/// public static extern JSContext CreateWithOptions([MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer, ref JSContextOptions options);
+DllPublic JSContext* CDecl CreateJSContextWithOptions(JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer, const JSContextOptions* options);
+///// Runs the foreground tasks V8 has posted for the context, such as
+///// finishing incremental GC or compilation done in the background, up to
+///// maxTasks of them, or all if 0. Returns the number of tasks run.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="PumpJSContextMessageLoop")]
+/// public static extern int PumpMessageLoop(JSContext context, int maxTasks);
+DllPublic int CDecl PumpJSContextMessageLoop(JSContext* context, int maxTasks);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSMicrotasksPolicy")]
+/// public static extern void SetMicrotasksPolicy(JSContext context, JSMicrotasksPolicy policy);
+DllPublic void CDecl SetJSMicrotasksPolicy(JSContext* context, JSMicrotasksPolicy policy);
+///// Runs the queued microtasks, and the ones they queue, until none are left
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RunJSMicrotasks")]
+/// public static extern void RunMicrotasks(JSContext context);
+DllPublic void CDecl RunJSMicrotasks(JSContext* context);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="EnqueueJSMicrotask")]
+/// public static extern void EnqueueMicrotask(JSContext context, JSFunction microtask);
+DllPublic void CDecl EnqueueJSMicrotask(JSContext* context, JSFunction* microtask);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateCreate")]
 /// public static extern JSValue EvaluateCreate(JSContext context, JSString fileName, JSString code, out JSScriptException error);
 DllPublic JSValue* CDecl JSContextEvaluateCreate(JSContext* context, JSString* fileName, JSString* code, JSScriptException** outError);
+///// Keeps the context's isolate locked and entered on the calling thread
+///// until the matching EndSession, so that the calls in between don't have
+///// to enter V8 one by one. Sessions nest, and must end on the thread that
+///// began them.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="BeginJSContextSession")]
+/// public static extern void BeginSession(JSContext context);
+DllPublic void CDecl BeginJSContextSession(JSContext* context);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="EndJSContextSession")]
+/// public static extern void EndSession(JSContext context);
+DllPublic void CDecl EndJSContextSession(JSContext* context);
+///// Handles released on other threads while the context is in use, such as
+///// by the finalizer during a session, are queued rather than waiting for
+///// the isolate lock. The queue is drained by the thread using the context
+///// when it's done with the isolate or next calls into the context, or by
+///// this, which returns how many were released.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DrainJSContextReleases")]
+/// public static extern int DrainReleases(JSContext context);
+DllPublic int CDecl DrainJSContextReleases(JSContext* context);
+///// When enabled, objects, arrays and functions returned from the context
+///// are returned as the same (retained) wrapper for as long as the wrapper is
+///// alive, instead of as a new wrapper each time. Off by default.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextIdentityCacheEnabled")]
+/// public static extern void SetIdentityCacheEnabled(JSContext context, [MarshalAs(UnmanagedType.I1)]bool enabled);
+DllPublic void CDecl SetJSContextIdentityCacheEnabled(JSContext* context, bool enabled);
+///// Limits how long each call into script may run. Script running past the
+///// limit is terminated, and the call fails with a Terminated exception.
+///// Pass 0 for no limit, the default.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSContextTimeout")]
+/// public static extern void SetTimeout(JSContext context, int milliseconds);
+DllPublic void CDecl SetJSContextTimeout(JSContext* context, int milliseconds);
+///// Terminates the script running on the context, from any thread. The
+///// running call fails with a Terminated exception, and the context can be
+///// used again afterwards.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="TerminateJSExecution")]
+/// public static extern void TerminateExecution(JSContext context);
+DllPublic void CDecl TerminateJSExecution(JSContext* context);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="IsJSExecutionTerminating")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool IsExecutionTerminating(JSContext context);
+DllPublic bool CDecl IsJSExecutionTerminating(JSContext* context);
+///// Lets script continue after a termination, e.g. from a callback that
+///// wants to recover from it.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CancelJSTerminateExecution")]
+/// public static extern void CancelTerminateExecution(JSContext context);
+DllPublic void CDecl CancelJSTerminateExecution(JSContext* context);
+///// Calls callback on the thread running script, as soon as possible. Can
+///// be called from any thread.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RequestJSInterrupt")]
+/// public static extern void RequestInterrupt(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSInterruptCallback callback);
+DllPublic void CDecl RequestJSInterrupt(JSContext* context, void* data, JSInterruptCallback callback);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextCopyGlobalObject")]
 /// public static extern JSObject CopyGlobalObject(JSContext context);
 DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context);
@@ -147,6 +603,198 @@ DllPublic JSObject* CDecl JSContextCopyGlobalObject(JSContext* context);
 DllPublic const char* CDecl GetV8Version();
 /// }
 
+/// // -------------------------------------------------------------------------
+/// // Async
+/// public static class Async
+/// {
+///// Gives the context a thread of its own that runs the calls submitted with
+///// EvaluateAsync and CallAsync in order, one batch per lock of the isolate.
+///// Submitting doesn't lock or block. Returns false if the context already
+///// has an executor or is single-threaded. The thread is stopped when the
+///// context is destroyed, which must then not happen on the executor thread.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StartJSContextExecutor")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool StartExecutor(JSContext context);
+DllPublic bool CDecl StartJSContextExecutor(JSContext* context);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSAsyncResult")]
+/// public static extern void Retain(JSAsyncResult result);
+DllPublic void CDecl RetainJSAsyncResult(JSAsyncResult* result);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSAsyncResult")]
+/// public static extern void Release(JSContext context, JSAsyncResult result);
+DllPublic void CDecl ReleaseJSAsyncResult(JSContext* context, JSAsyncResult* result);
+///// Like Context.EvaluateCreate, but queued on the context's executor.
+///// callback, which may be null, is called once the result is in. Returns
+///// null if the context has no executor. Calls still queued when the context
+///// is destroyed are dropped without calling callback, and data is passed to
+///// the context's external finalizer.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSContextEvaluateAsync")]
+/// public static extern JSAsyncResult EvaluateAsync(JSContext context, JSString fileName, JSString code, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSAsyncCallback callback);
+DllPublic JSAsyncResult* CDecl JSContextEvaluateAsync(JSContext* context, JSString* fileName, JSString* code, void* data, JSAsyncCallback callback);
+///// Like Value.CallCreate, but queued on the context's executor like
+///// EvaluateAsync. The function, receiver and arguments are retained until
+///// the call has run.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CallJSFunctionAsync")]
+/// public static extern JSAsyncResult CallAsync(JSContext context, JSFunction function, JSObject thisObject, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSValue[] args, int numArgs, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSAsyncCallback callback);
+DllPublic JSAsyncResult* CDecl CallJSFunctionAsync(JSContext* context, JSFunction* function, JSObject* thisObject, JSValue* const* args, int numArgs, void* data, JSAsyncCallback callback);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="IsJSAsyncResultDone")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool IsDone(JSAsyncResult result);
+DllPublic bool CDecl IsJSAsyncResultDone(JSAsyncResult* result);
+///// Waits up to timeoutMilliseconds, or for as long as it takes if negative,
+///// for the call to complete. Returns whether it has.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WaitJSAsyncResult")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool Wait(JSAsyncResult result, int timeoutMilliseconds);
+DllPublic bool CDecl WaitJSAsyncResult(JSAsyncResult* result, int timeoutMilliseconds);
+///// The value the completed call returned, or null if it hasn't completed
+///// or threw
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSAsyncResultValue")]
+/// public static extern JSValue CopyValue(JSAsyncResult result);
+DllPublic JSValue* CDecl CopyJSAsyncResultValue(JSAsyncResult* result);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSAsyncResultError")]
+/// public static extern JSScriptException CopyError(JSAsyncResult result);
+DllPublic JSScriptException* CDecl CopyJSAsyncResultError(JSAsyncResult* result);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Context pool
+/// public static class ContextPool
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSContextPool")]
+/// public static extern void Retain(JSContextPool pool);
+DllPublic void CDecl RetainJSContextPool(JSContextPool* pool);
+///// Releases the idle contexts too. Contexts acquired from the pool keep it
+///// alive until they are released.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSContextPool")]
+/// public static extern void Release(JSContextPool pool);
+DllPublic void CDecl ReleaseJSContextPool(JSContextPool* pool);
+///// Keeps up to maxIdleContexts released contexts, with their isolates, for
+///// reuse. With resetContexts, the contexts get a fresh global object when
+///// they are returned; otherwise they are reused as they are.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSContextPool")]
+/// public static extern JSContextPool Create(int maxIdleContexts, [MarshalAs(UnmanagedType.I1)]bool resetContexts, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallbackFinalizer callbackFinalizer, [MarshalAs(UnmanagedType.FunctionPtr)]JSExternalFinalizer externalFinalizer);
+DllPublic JSContextPool* CDecl CreateJSContextPool(int maxIdleContexts, bool resetContexts, JSCallbackFinalizer callbackFinalizer, JSExternalFinalizer externalFinalizer);
+///// Returns an idle context if there is one, and creates a new one otherwise.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AcquireJSContext")]
+/// public static extern JSContext Acquire(JSContextPool pool);
+DllPublic JSContext* CDecl AcquireJSContext(JSContextPool* pool);
+///// Releases the context, handing it back to the pool if it isn't referenced
+///// elsewhere and the pool has room for it. Values and exceptions from the
+///// context must be released first.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSContextToPool")]
+/// public static extern void ReleaseContext(JSContextPool pool, JSContext context);
+DllPublic void CDecl ReleaseJSContextToPool(JSContextPool* pool, JSContext* context);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextPoolStatistics")]
+/// public static extern void GetStatistics(JSContextPool pool, out JSContextPoolStatistics statistics);
+DllPublic void CDecl GetJSContextPoolStatistics(JSContextPool* pool, JSContextPoolStatistics* outStatistics);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Snapshot
+/// public static class Snapshot
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSnapshot")]
+/// public static extern void Retain(JSSnapshot snapshot);
+DllPublic void CDecl RetainJSSnapshot(JSSnapshot* snapshot);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSnapshot")]
+/// public static extern void Release(JSSnapshot snapshot);
+DllPublic void CDecl ReleaseJSSnapshot(JSSnapshot* snapshot);
+///// Evaluates the sources in order in a fresh context, and serializes the
+///// resulting heap into a startup snapshot. The sources can't use callbacks,
+///// externals or ArrayBuffers. Sets error to ScriptError if a source throws.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSnapshot")]
+/// public static extern JSSnapshot Create([In, MarshalAs(UnmanagedType.LPArray, ArraySubType = UnmanagedType.LPWStr, SizeParamIndex = 2)]string[] sources, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]int[] sourceLengths, int numSources, out JSRuntimeError error);
+DllPublic JSSnapshot* CDecl CreateJSSnapshot(const uint16_t* const* sources, const int* sourceLengths, int numSources, JSRuntimeError* outError);
+/// public static JSSnapshot Create(string[] sources, out JSRuntimeError error)
+/// {
+/// 	var sourceLengths = new int[sources.Length];
+/// 	for (int i = 0; i < sources.Length; ++i)
+/// 		sourceLengths[i] = sources[i].Length;
+/// 	return Create(sources, sourceLengths, sources.Length, out error);
+/// }
+///// Returns the length of the snapshot blob, and copies it to buffer if
+///// bufferLength is large enough.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSSnapshotData")]
+/// public static extern int CopyData(JSSnapshot snapshot, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+DllPublic int CDecl CopyJSSnapshotData(JSSnapshot* snapshot, uint8_t* outBuffer, int bufferLength);
+/// public static byte[] GetData(JSSnapshot snapshot)
+/// {
+/// 	var buffer = new byte[CopyData(snapshot, null, 0)];
+/// 	CopyData(snapshot, buffer, buffer.Length);
+/// 	return buffer;
+/// }
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Script
+/// public static class Script
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSScript")]
+/// public static extern void Retain(JSContext context, JSScript script);
+DllPublic void CDecl RetainJSScript(JSContext* context, JSScript* script);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSScript")]
+/// public static extern void Release(JSContext context, JSScript script);
+DllPublic void CDecl ReleaseJSScript(JSContext* context, JSScript* script);
+///// Compiles without running. Pass the code cache from an earlier compile of
+///// the same source to skip parsing and compiling; cacheRejected is set if
+///// V8 couldn't use it (e.g. after a V8 upgrade). Without a cache, a new one
+///// is produced and can be read with CopyCodeCache.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CompileJSScript")]
+/// public static extern JSScript Compile(JSContext context, JSString fileName, JSString code, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]byte[] cacheData, int cacheLength, [MarshalAs(UnmanagedType.I1)]out bool cacheRejected, out JSScriptException error);
+DllPublic JSScript* CDecl CompileJSScript(JSContext* context, JSString* fileName, JSString* code, const uint8_t* cacheData, int cacheLength, bool* outCacheRejected, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RunJSScript")]
+/// public static extern JSValue Run(JSContext context, JSScript script, out JSScriptException error);
+DllPublic JSValue* CDecl RunJSScript(JSContext* context, JSScript* script, JSScriptException** outError);
+///// Returns the length of the code cache produced by Compile, and copies it
+///// to buffer if bufferLength is large enough.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSScriptCodeCache")]
+/// public static extern int CopyCodeCache(JSScript script, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+DllPublic int CDecl CopyJSScriptCodeCache(JSScript* script, uint8_t* outBuffer, int bufferLength);
+/// public static byte[] GetCodeCache(JSScript script)
+/// {
+/// 	var buffer = new byte[CopyCodeCache(script, null, 0)];
+/// 	CopyCodeCache(script, buffer, buffer.Length);
+/// 	return buffer;
+/// }
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Class
+/// public static class Class
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSClass")]
+/// public static extern void Retain(JSContext context, JSClass cls);
+DllPublic void CDecl RetainJSClass(JSContext* context, JSClass* cls);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSClass")]
+/// public static extern void Release(JSContext context, JSClass cls);
+DllPublic void CDecl ReleaseJSClass(JSContext* context, JSClass* cls);
+///// Creates a class of objects with native data. Instances share a hidden
+///// class, and can only be created with CreateInstance.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSClass")]
+/// public static extern JSClass Create(JSContext context, JSString name);
+DllPublic JSClass* CDecl CreateJSClass(JSContext* context, JSString* name);
+///// Adds a prototype method. The callback gets the instance as args[0],
+///// followed by the call's arguments. Methods and accessors can't be added
+///// once an instance has been created (TypeError).
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AddJSClassMethod")]
+/// public static extern void AddMethod(JSContext context, JSClass cls, JSString name, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSRuntimeError error);
+DllPublic void CDecl AddJSClassMethod(JSContext* context, JSClass* cls, JSString* name, void* data, JSCallback callback, JSRuntimeError* outError);
+///// Adds a prototype accessor. The getter gets the instance as args[0], and
+///// the setter the instance and the new value. The setter may be null.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AddJSClassAccessor")]
+/// public static extern void AddAccessor(JSContext context, JSClass cls, JSString name, IntPtr getterData, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback getter, IntPtr setterData, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback setter, out JSRuntimeError error);
+DllPublic void CDecl AddJSClassAccessor(JSContext* context, JSClass* cls, JSString* name, void* getterData, JSCallback getter, void* setterData, JSCallback setter, JSRuntimeError* outError);
+///// Creates an instance holding data, which is passed to the context's
+///// external finalizer when the instance is garbage collected.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSClassInstance")]
+/// public static extern JSObject CreateInstance(JSContext context, JSClass cls, IntPtr data, out JSScriptException error);
+DllPublic JSObject* CDecl CreateJSClassInstance(JSContext* context, JSClass* cls, void* data, JSScriptException** outError);
+///// Gets the data of an instance of cls. Sets TypeError if obj isn't one.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSClassInstanceData")]
+/// public static extern IntPtr GetInstanceData(JSContext context, JSClass cls, JSObject obj, out JSRuntimeError error);
+DllPublic void* CDecl GetJSClassInstanceData(JSContext* context, JSClass* cls, JSObject* obj, JSRuntimeError* outError);
+/// }
+
 /// // -------------------------------------------------------------------------
 /// // Debug
 /// public static class Debug
@@ -162,6 +810,124 @@ DllPublic void CDecl SendJSDebugCommand(JSContext* context, const uint16_t* comm
 DllPublic void CDecl ProcessJSDebugMessages(JSContext* context);
 /// }
 
+/// // -------------------------------------------------------------------------
+/// // Profiler
+/// public static class Profiler
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSProfile")]
+/// public static extern void Retain(JSProfile profile);
+DllPublic void CDecl RetainJSProfile(JSProfile* profile);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSProfile")]
+/// public static extern void Release(JSProfile profile);
+DllPublic void CDecl ReleaseJSProfile(JSProfile* profile);
+///// Returns the length of the profile's UTF-8 JSON, and copies it to buffer if
+///// bufferLength is large enough.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSProfileData")]
+/// public static extern int CopyData(JSProfile profile, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+DllPublic int CDecl CopyJSProfileData(JSProfile* profile, char* outBuffer, int bufferLength);
+///// Starts sampling the context's script every samplingIntervalMicroseconds,
+///// or at V8's default rate (1 ms) if 0. Profiles with different titles can
+///// run at the same time, sampled at the interval of the first one; the
+///// interval is ignored while another profile is running. Starting a title
+///// that is already running does nothing.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StartJSCpuProfile")]
+/// public static extern void StartCpuProfile(JSContext context, JSString title, int samplingIntervalMicroseconds);
+DllPublic void CDecl StartJSCpuProfile(JSContext* context, JSString* title, int samplingIntervalMicroseconds);
+///// Records a sample of the current stack right away, e.g. from a callback
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CollectJSCpuProfileSample")]
+/// public static extern void CollectCpuProfileSample(JSContext context);
+DllPublic void CDecl CollectJSCpuProfileSample(JSContext* context);
+///// Stops the profile started with title and returns it in the .cpuprofile
+///// format that Chrome's DevTools loads. Returns null if there's no such
+///// profile.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StopJSCpuProfile")]
+/// public static extern JSProfile StopCpuProfile(JSContext context, JSString title);
+DllPublic JSProfile* CDecl StopJSCpuProfile(JSContext* context, JSString* title);
+///// Returns a snapshot of the heap in the .heapsnapshot format
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="TakeJSHeapSnapshot")]
+/// public static extern JSProfile TakeHeapSnapshot(JSContext context);
+DllPublic JSProfile* CDecl TakeJSHeapSnapshot(JSContext* context);
+///// Starts or stops counting and timing the calls in JSInstrumentedCall, for
+///// all contexts. Returns false, and does nothing, unless the library was
+///// built with V8SIMPLE_INSTRUMENTATION (make INSTRUMENTATION=1).
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSInstrumentationEnabled")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool SetInstrumentationEnabled([MarshalAs(UnmanagedType.I1)]bool enabled);
+DllPublic bool CDecl SetJSInstrumentationEnabled(bool enabled);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSCallCounter")]
+/// public static extern void GetCallCounter(JSInstrumentedCall call, out JSCallCounter counter);
+DllPublic void CDecl GetJSCallCounter(JSInstrumentedCall call, JSCallCounter* outCounter);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectCounters")]
+/// public static extern void GetObjectCounters(out JSObjectCounters counters);
+DllPublic void CDecl GetJSObjectCounters(JSObjectCounters* outCounters);
+///// Zeroes the call counters and WrapperAllocations
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ResetJSInstrumentationCounters")]
+/// public static extern void ResetInstrumentationCounters();
+DllPublic void CDecl ResetJSInstrumentationCounters();
+///// Records trace events in the comma separated categories, or in "v8simple"
+///// and "v8" if null, to path in the Trace Event format that
+///// chrome://tracing loads. The v8simple category has an event per
+///// instrumented call when instrumentation is built in. Returns false if
+///// already tracing or if path can't be opened.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StartJSTracing")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool StartTracing([MarshalAs(UnmanagedType.LPStr)]string path, [MarshalAs(UnmanagedType.LPStr)]string categories);
+DllPublic bool CDecl StartJSTracing(const char* path, const char* categories);
+///// Writes out the recorded events and closes the file. No script may be
+///// running while tracing stops.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StopJSTracing")]
+/// public static extern void StopTracing();
+DllPublic void CDecl StopJSTracing();
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Heap
+/// public static class Heap
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHeapStatistics")]
+/// public static extern void GetStatistics(JSContext context, out JSHeapStatistics statistics);
+DllPublic void CDecl GetJSContextHeapStatistics(JSContext* context, JSHeapStatistics* outStatistics);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHeapSpaceCount")]
+/// public static extern int GetSpaceCount(JSContext context);
+DllPublic int CDecl GetJSContextHeapSpaceCount(JSContext* context);
+///// Returns false if index is out of range
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextHeapSpaceStatistics")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool GetSpaceStatistics(JSContext context, int index, out JSHeapSpaceStatistics statistics);
+DllPublic bool CDecl GetJSContextHeapSpaceStatistics(JSContext* context, int index, JSHeapSpaceStatistics* outStatistics);
+///// Replaces the GC event handler. The old data is passed to the context's
+///// external finalizer. Pass null to stop reporting.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSGCEventHandler")]
+/// public static extern void SetGCEventHandler(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSGCEventHandler handler);
+DllPublic void CDecl SetJSGCEventHandler(JSContext* context, void* data, JSGCEventHandler handler);
+///// Forwards an OS memory warning to V8. Unlike the other calls, this can be
+///// made from any thread while the context is running script.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSMemoryPressure")]
+/// public static extern void NotifyMemoryPressure(JSContext context, JSMemoryPressureLevel level);
+DllPublic void CDecl NotifyJSMemoryPressure(JSContext* context, JSMemoryPressureLevel level);
+///// Lets V8 use the next idleMilliseconds for garbage collection. Returns
+///// true if there's nothing more to do until script has run again.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSIdle")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool NotifyIdle(JSContext context, double idleMilliseconds);
+DllPublic bool CDecl NotifyJSIdle(JSContext* context, double idleMilliseconds);
+///// Runs a full garbage collection, freeing as much memory as possible,
+///// including the array buffers pooled for reuse
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="NotifyJSLowMemory")]
+/// public static extern void NotifyLowMemory(JSContext context);
+DllPublic void CDecl NotifyJSLowMemory(JSContext* context);
+///// Counts the buffers allocated by the context's array buffer allocator.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSContextArrayBufferStatistics")]
+/// public static extern void GetArrayBufferStatistics(JSContext context, out JSArrayBufferStatistics statistics);
+DllPublic void CDecl GetJSContextArrayBufferStatistics(JSContext* context, JSArrayBufferStatistics* outStatistics);
+///// Tells V8 that script objects keep changeInBytes more (or, if negative,
+///// less) native memory alive, such as the data of external array buffers.
+///// Returns the new total.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="AdjustJSExternalMemory")]
+/// public static extern long AdjustExternalMemory(JSContext context, long changeInBytes);
+DllPublic int64_t CDecl AdjustJSExternalMemory(JSContext* context, int64_t changeInBytes);
+/// }
+
 /// // -------------------------------------------------------------------------
 /// // Value
 /// public static class Value
@@ -223,26 +989,88 @@ DllPublic JSValue* CDecl CreateJSBool(bool value);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSArrayBuffer")]
 /// public static extern JSObject CreateExternalArrayBuffer(JSContext context, IntPtr data, int byteLength);
 DllPublic JSObject* CDecl CreateExternalJSArrayBuffer(JSContext* context, void* data, int byteLength);
+///// Like CreateExternalArrayBuffer, but counts byteLength bytes as external
+///// memory until the buffer is garbage collected, so that V8 collects it
+///// sooner. finalizerData, if not null, is then passed to the external
+///// finalizer, which should free data.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateSizedExternalJSArrayBuffer")]
+/// public static extern JSObject CreateSizedExternalArrayBuffer(JSContext context, IntPtr data, int byteLength, IntPtr finalizerData, out JSRuntimeError error);
+DllPublic JSObject* CDecl CreateSizedExternalJSArrayBuffer(JSContext* context, void* data, int byteLength, void* finalizerData, JSRuntimeError* outError);
+///// Creates a zero-filled ArrayBuffer whose memory is owned by V8. Fails
+///// with RangeError if byteLength is negative.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSArrayBuffer")]
+/// public static extern JSObject CreateArrayBuffer(JSContext context, int byteLength, out JSRuntimeError error);
+DllPublic JSObject* CDecl CreateJSArrayBuffer(JSContext* context, int byteLength, JSRuntimeError* outError);
+///// Creates a view of length elements into arrayBuffer starting at byteOffset.
+///// Sets RangeError if the view doesn't fit or byteOffset isn't aligned to
+///// the element size.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSTypedArray")]
+/// public static extern JSObject CreateTypedArray(JSContext context, JSObject arrayBuffer, JSTypedArrayType type, int byteOffset, int length, out JSRuntimeError error);
+DllPublic JSObject* CDecl CreateJSTypedArray(JSContext* context, JSObject* arrayBuffer, JSTypedArrayType type, int byteOffset, int length, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSCallback")]
 /// public static extern JSFunction CreateCallback(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSCallback callback, out JSScriptException error);
 DllPublic JSFunction* CDecl CreateJSCallback(JSContext* context, void* data, JSCallback callback, JSScriptException** outError);
+///// Creates a function calling a JSFastCallback. Up to eight arguments are
+///// passed without allocating, and numbers and bools in either direction
+///// don't allocate wrappers.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSFastCallback")]
+/// public static extern JSFunction CreateFastCallback(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSFastCallback callback, out JSScriptException error);
+DllPublic JSFunction* CDecl CreateJSFastCallback(JSContext* context, void* data, JSFastCallback callback, JSScriptException** outError);
 
 /// // --------------------------------------------------------------------------
 /// // String
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSString")]
 /// public static extern JSString CreateString(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string buffer, int length, out JSRuntimeError error);
 DllPublic JSString* CDecl CreateJSString(JSContext* context, const uint16_t* buffer, int length, JSRuntimeError* outError);
+///// Creates an internalized string for use as a property name. Keys are
+///// cached on the context, so creating the same key again returns the same
+///// (retained) string without touching V8, and property lookups with it don't
+///// have to internalize it first.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSPropertyKey")]
+/// public static extern JSString CreatePropertyKey(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string buffer, int length, out JSRuntimeError error);
+DllPublic JSString* CDecl CreateJSPropertyKey(JSContext* context, const uint16_t* buffer, int length, JSRuntimeError* outError);
+///// Creates a string that uses buffer directly instead of copying it. The
+///// buffer must stay alive and unchanged until the context's external
+///// finalizer is called with data, which happens when V8 collects the string.
+///// On error, nothing is finalized.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalJSString")]
+/// public static extern JSString CreateExternalString(JSContext context, IntPtr buffer, int length, IntPtr data, out JSRuntimeError error);
+DllPublic JSString* CDecl CreateExternalJSString(JSContext* context, const uint16_t* buffer, int length, void* data, JSRuntimeError* outError);
+///// Like CreateExternalString, for a buffer of Latin-1 characters
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateExternalOneByteJSString")]
+/// public static extern JSString CreateExternalOneByteString(JSContext context, IntPtr buffer, int length, IntPtr data, out JSRuntimeError error);
+DllPublic JSString* CDecl CreateExternalOneByteJSString(JSContext* context, const char* buffer, int length, void* data, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSStringLength")]
 /// public static extern int Length(JSContext context, JSString str);
 DllPublic int CDecl JSStringLength(JSContext* context, JSString* string);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStringBuffer")]
 /// public static extern void Write(JSContext context, JSString str, [Out, MarshalAs(UnmanagedType.LPWStr)]StringBuilder buffer, [MarshalAs(UnmanagedType.I1)]bool nullTerminate);
 DllPublic void CDecl WriteJSStringBuffer(JSContext* context, JSString* string, uint16_t* outBuffer, bool nullTerminate);
+///// Writes the string to buffer without null termination if it fits in
+///// bufferLength characters. Returns the string's length either way.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode, EntryPoint="WriteJSStringUtf16")]
+/// public static extern int Write(JSContext context, JSString str, [Out] char[] buffer, int bufferLength);
+DllPublic int CDecl WriteJSStringUtf16(JSContext* context, JSString* string, uint16_t* outBuffer, int bufferLength);
+///// Writes the string to buffer as UTF-8, without null termination, if it
+///// fits in bufferLength bytes. Returns the number of bytes written, or the
+///// number of bytes needed if it doesn't fit.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="WriteJSStringUtf8")]
+/// public static extern int WriteUtf8(JSContext context, JSString str, [Out] byte[] buffer, int bufferLength);
+DllPublic int CDecl WriteJSStringUtf8(JSContext* context, JSString* string, char* outBuffer, int bufferLength);
+/// const int MaxCachedStringBufferLength = 64 * 1024;
+/// [ThreadStatic] static char[] _stringBuffer;
 /// public static string ToString(JSContext context, JSString str)
 /// {
-/// 	var sb = new StringBuilder(Length(context, str) + 1);
-/// 	Write(context, str, sb, true);
-/// 	return sb.ToString();
+/// 	var buffer = _stringBuffer ?? (_stringBuffer = new char[256]);
+/// 	var length = Write(context, str, buffer, buffer.Length);
+/// 	if (length > buffer.Length)
+/// 	{
+/// 		buffer = new char[length];
+/// 		if (length <= MaxCachedStringBufferLength)
+/// 			_stringBuffer = buffer;
+/// 		length = Write(context, str, buffer, buffer.Length);
+/// 	}
+/// 	return new string(buffer, 0, length);
 /// }
 
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSStringAsValue")]
@@ -257,6 +1085,15 @@ DllPublic JSValue* CDecl CopyJSObjectProperty(JSContext* context, JSObject* obj,
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectProperty")]
 /// public static extern void SetProperty(JSContext context, JSObject obj, JSString key, JSValue value, out JSScriptException error);
 DllPublic void CDecl SetJSObjectProperty(JSContext* context, JSObject* obj, JSString* key, JSValue* value, JSScriptException** outError);
+///// Gets count properties in one call. If one throws, error is set and
+///// values is left null.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectProperties")]
+/// public static extern void CopyProperties(JSContext context, JSObject obj, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSString[] keys, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSValue[] values, int count, out JSScriptException error);
+DllPublic void CDecl CopyJSObjectProperties(JSContext* context, JSObject* obj, JSString* const* keys, JSValue** outValues, int count, JSScriptException** outError);
+///// Sets count properties in one call, stopping at the first that throws.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSObjectProperties")]
+/// public static extern void SetProperties(JSContext context, JSObject obj, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSString[] keys, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 4)]JSValue[] values, int count, out JSScriptException error);
+DllPublic void CDecl SetJSObjectProperties(JSContext* context, JSObject* obj, JSString* const* keys, JSValue* const* values, int count, JSScriptException** outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectOwnPropertyNames")]
 /// public static extern JSArray CopyOwnPropertyNames(JSContext context, JSObject obj, out JSScriptException error);
 DllPublic JSArray* CDecl CopyJSObjectOwnPropertyNames(JSContext* context, JSObject* obj, JSScriptException** outError);
@@ -267,6 +1104,16 @@ DllPublic bool CDecl JSObjectHasProperty(JSContext* context, JSObject* obj, JSSt
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectArrayBufferData")]
 /// public static extern IntPtr GetArrayBufferData(JSContext context, JSObject obj, out JSRuntimeError outError);
 DllPublic void* CDecl GetJSObjectArrayBufferData(JSContext* context, JSObject* obj, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectArrayBufferByteLength")]
+/// public static extern int GetArrayBufferByteLength(JSContext context, JSObject obj, out JSRuntimeError outError);
+DllPublic int CDecl GetJSObjectArrayBufferByteLength(JSContext* context, JSObject* obj, JSRuntimeError* outError);
+///// Gets the type, size and data pointer of a typed array in one call
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSObjectTypedArrayInfo")]
+/// public static extern void GetTypedArrayInfo(JSContext context, JSObject obj, out JSTypedArrayInfo info, out JSRuntimeError outError);
+DllPublic void CDecl GetJSObjectTypedArrayInfo(JSContext* context, JSObject* obj, JSTypedArrayInfo* outInfo, JSRuntimeError* outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSObjectTypedArrayBuffer")]
+/// public static extern JSObject CopyTypedArrayBuffer(JSContext context, JSObject obj, out JSRuntimeError outError);
+DllPublic JSObject* CDecl CopyJSObjectTypedArrayBuffer(JSContext* context, JSObject* obj, JSRuntimeError* outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSObjectAsValue")]
 /// public static extern JSValue AsValue(JSObject obj);
 DllPublic JSValue* CDecl JSObjectAsValue(JSObject* obj);
@@ -279,6 +1126,18 @@ DllPublic JSValue* CDecl CopyJSArrayPropertyAtIndex(JSContext* context, JSArray*
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayPropertyAtIndex")]
 /// public static extern void SetProperty(JSContext context, JSArray arr, int index, JSValue value, out JSScriptException error);
 DllPublic void CDecl SetJSArrayPropertyAtIndex(JSContext* context, JSArray* arr, int index, JSValue* value, JSScriptException** outError);
+///// Gets the elements start ... start + count - 1 in one call. If one
+///// throws, error is set and values is left null. Sets runtimeError to
+///// RangeError, without touching the array, if start or count is negative
+///// or start + count overflows.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSArrayRange")]
+/// public static extern void CopyRange(JSContext context, JSArray arr, int start, int count, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSValue[] values, out JSRuntimeError runtimeError, out JSScriptException error);
+DllPublic void CDecl CopyJSArrayRange(JSContext* context, JSArray* arr, int start, int count, JSValue** outValues, JSRuntimeError* outRuntimeError, JSScriptException** outError);
+///// Sets the elements start ... start + count - 1 in one call, stopping at
+///// the first that throws. Range errors are reported as for CopyRange.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSArrayRange")]
+/// public static extern void SetRange(JSContext context, JSArray arr, int start, int count, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSValue[] values, out JSRuntimeError runtimeError, out JSScriptException error);
+DllPublic void CDecl SetJSArrayRange(JSContext* context, JSArray* arr, int start, int count, JSValue* const* values, JSRuntimeError* outRuntimeError, JSScriptException** outError);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSArrayLength")]
 /// public static extern int Length(JSContext context, JSArray arr);
 DllPublic int CDecl JSArrayLength(JSContext* context, JSArray* arr);
@@ -303,6 +1162,11 @@ DllPublic JSValue* CDecl JSFunctionAsValue(JSFunction* fun);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSExternal")]
 /// public static extern JSExternal CreateExternal(JSContext context, IntPtr value);
 DllPublic JSExternal* CDecl CreateJSExternal(JSContext* context, void* value);
+///// Like CreateExternal, but counts size bytes as external memory until the
+///// external is finalized, so that V8 collects it sooner.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateSizedJSExternal")]
+/// public static extern JSExternal CreateSizedExternal(JSContext context, IntPtr value, long size);
+DllPublic JSExternal* CDecl CreateSizedJSExternal(JSContext* context, void* value, int64_t size);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSExternalValue")]
 /// public static extern IntPtr GetExternalValue(JSContext context, JSExternal external);
 DllPublic void* CDecl GetJSExternalValue(JSContext* context, JSExternal* external);
@@ -321,6 +1185,8 @@ DllPublic void CDecl RetainJSScriptException(JSContext* context, JSScriptExcepti
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSScriptException")]
 /// public static extern void Release(JSContext context, JSScriptException e);
 DllPublic void CDecl ReleaseJSScriptException(JSContext* context, JSScriptException* e);
+///// The getters make their results from the exception the first time they're
+///// called, which locks its context. The results are owned by the exception.
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptException")]
 /// public static extern JSValue GetException(JSScriptException e);
 DllPublic JSValue* CDecl GetJSScriptException(JSScriptException* e);
@@ -333,6 +1199,9 @@ DllPublic JSString* CDecl GetJSScriptExceptionFileName(JSScriptException* e);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionLineNumber")]
 /// public static extern int GetLineNumber(JSScriptException e);
 DllPublic int CDecl GetJSScriptExceptionLineNumber(JSScriptException* e);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionKind")]
+/// public static extern JSScriptExceptionKind GetKind(JSScriptException e);
+DllPublic JSScriptExceptionKind CDecl GetJSScriptExceptionKind(JSScriptException* e);
 /// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="GetJSScriptExceptionStackTrace")]
 /// public static extern JSString GetStackTrace(JSScriptException e);
 DllPublic JSString* CDecl GetJSScriptExceptionStackTrace(JSScriptException* e);
@@ -341,4 +1210,128 @@ DllPublic JSString* CDecl GetJSScriptExceptionStackTrace(JSScriptException* e);
 DllPublic JSString* CDecl GetJSScriptExceptionSourceLine(JSScriptException* e);
 /// }
 
+/// // -------------------------------------------------------------------------
+/// // Json
+/// public static class Json
+/// {
+///// Parses json in one call. Pass a string made with CreateExternalString to
+///// parse without copying the text.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ParseJSJson")]
+/// public static extern JSValue Parse(JSContext context, JSString json, out JSScriptException error);
+DllPublic JSValue* CDecl ParseJSJson(JSContext* context, JSString* json, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ParseJSJsonUtf16")]
+/// public static extern JSValue Parse(JSContext context, [MarshalAs(UnmanagedType.LPWStr, SizeParamIndex = 2)]string json, int length, out JSScriptException error);
+DllPublic JSValue* CDecl ParseJSJsonUtf16(JSContext* context, const uint16_t* buffer, int length, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ParseJSJsonUtf8")]
+/// public static extern JSValue ParseUtf8(JSContext context, byte[] json, int length, out JSScriptException error);
+DllPublic JSValue* CDecl ParseJSJsonUtf8(JSContext* context, const char* buffer, int length, JSScriptException** outError);
+///// Like JSON.stringify(value, null, indent). Values JSON can't represent,
+///// such as functions, give an empty string.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StringifyJSValue")]
+/// public static extern JSString Stringify(JSContext context, JSValue value, int indent, out JSScriptException error);
+DllPublic JSString* CDecl StringifyJSValue(JSContext* context, JSValue* value, int indent, JSScriptException** outError);
+///// Writes the JSON to buffer without null termination if it fits in
+///// bufferLength characters. Returns its length either way.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, CharSet = CharSet.Unicode, EntryPoint="StringifyJSValueUtf16")]
+/// public static extern int Stringify(JSContext context, JSValue value, int indent, [Out] char[] buffer, int bufferLength, out JSScriptException error);
+DllPublic int CDecl StringifyJSValueUtf16(JSContext* context, JSValue* value, int indent, uint16_t* outBuffer, int bufferLength, JSScriptException** outError);
+///// Writes the JSON to buffer as UTF-8 if it fits in bufferLength bytes.
+///// Returns the number of bytes written, or needed if it doesn't fit.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="StringifyJSValueUtf8")]
+/// public static extern int StringifyUtf8(JSContext context, JSValue value, int indent, [Out] byte[] buffer, int bufferLength, out JSScriptException error);
+DllPublic int CDecl StringifyJSValueUtf8(JSContext* context, JSValue* value, int indent, char* outBuffer, int bufferLength, JSScriptException** outError);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Serializer
+/// public static class Serializer
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSSerializedValue")]
+/// public static extern void Retain(JSSerializedValue value);
+DllPublic void CDecl RetainJSSerializedValue(JSSerializedValue* value);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSSerializedValue")]
+/// public static extern void Release(JSSerializedValue value);
+DllPublic void CDecl ReleaseJSSerializedValue(JSSerializedValue* value);
+///// Serializes value like the structured clone algorithm, so that it can be
+///// deserialized into other contexts. The contents of the array buffers in
+///// transfer are moved into the serialized value, and the buffers are
+///// detached. The first deserialization takes them over, without copying if
+///// both contexts use the same kind of array buffer allocator; deserializing
+///// again then fails.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SerializeJSValue")]
+/// public static extern JSSerializedValue Serialize(JSContext context, JSValue value, [In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 3)]JSObject[] transfer, int transferCount, out JSScriptException error);
+DllPublic JSSerializedValue* CDecl SerializeJSValue(JSContext* context, JSValue* value, JSObject* const* transfer, int transferCount, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="DeserializeJSValue")]
+/// public static extern JSValue Deserialize(JSContext context, JSSerializedValue value, out JSScriptException error);
+DllPublic JSValue* CDecl DeserializeJSValue(JSContext* context, JSSerializedValue* value, JSScriptException** outError);
+///// Makes a serialized value from data copied with CopyData. Transferred
+///// array buffers aren't part of the data.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSSerializedValue")]
+/// public static extern JSSerializedValue Create([In, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 1)]byte[] data, int length);
+DllPublic JSSerializedValue* CDecl CreateJSSerializedValue(const uint8_t* data, int length);
+///// Returns the length of the serialized data, and copies it to buffer if
+///// bufferLength is large enough.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSSerializedValueData")]
+/// public static extern int CopyData(JSSerializedValue value, [Out, MarshalAs(UnmanagedType.LPArray, SizeParamIndex = 2)]byte[] buffer, int bufferLength);
+DllPublic int CDecl CopyJSSerializedValueData(JSSerializedValue* value, uint8_t* outBuffer, int bufferLength);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Promise
+/// public static class Promise
+/// {
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RetainJSPromiseResolver")]
+/// public static extern void Retain(JSPromiseResolver resolver);
+DllPublic void CDecl RetainJSPromiseResolver(JSPromiseResolver* resolver);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ReleaseJSPromiseResolver")]
+/// public static extern void Release(JSContext context, JSPromiseResolver resolver);
+DllPublic void CDecl ReleaseJSPromiseResolver(JSContext* context, JSPromiseResolver* resolver);
+///// Creates a pending promise, for native code to settle with Resolve or
+///// Reject
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CreateJSPromiseResolver")]
+/// public static extern JSPromiseResolver CreateResolver(JSContext context, out JSScriptException error);
+DllPublic JSPromiseResolver* CDecl CreateJSPromiseResolver(JSContext* context, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSPromiseResolverPromise")]
+/// public static extern JSObject CopyPromise(JSContext context, JSPromiseResolver resolver);
+DllPublic JSObject* CDecl CopyJSPromiseResolverPromise(JSContext* context, JSPromiseResolver* resolver);
+///// Settles the resolver's promise, unless it's already settled. Its
+///// reactions run as microtasks.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="ResolveJSPromise")]
+/// public static extern void Resolve(JSContext context, JSPromiseResolver resolver, JSValue value, out JSScriptException error);
+DllPublic void CDecl ResolveJSPromise(JSContext* context, JSPromiseResolver* resolver, JSValue* value, JSScriptException** outError);
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RejectJSPromise")]
+/// public static extern void Reject(JSContext context, JSPromiseResolver resolver, JSValue value, out JSScriptException error);
+DllPublic void CDecl RejectJSPromise(JSContext* context, JSPromiseResolver* resolver, JSValue* value, JSScriptException** outError);
+///// Whether anything is waiting for the promise to settle, e.g. to find
+///// rejections nobody handles
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="JSPromiseHasHandler")]
+/// [return: MarshalAs(UnmanagedType.I1)]
+/// public static extern bool HasHandler(JSContext context, JSObject promise);
+DllPublic bool CDecl JSPromiseHasHandler(JSContext* context, JSObject* promise);
+/// }
+
+/// // -------------------------------------------------------------------------
+/// // Module
+/// public static class Module
+/// {
+///// Lets the context load CommonJS modules through resolver and loader. A
+///// module is compiled, and run with exports, require, module and
+///// __filename, the first time it's required; later requires return its
+///// module.exports. Setting a loader forgets the modules loaded so far. The
+///// previous data is passed to the context's external finalizer.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="SetJSModuleLoader")]
+/// public static extern void SetLoader(JSContext context, IntPtr data, [MarshalAs(UnmanagedType.FunctionPtr)]JSModuleResolver resolver, [MarshalAs(UnmanagedType.FunctionPtr)]JSModuleLoader loader);
+DllPublic void CDecl SetJSModuleLoader(JSContext* context, void* data, JSModuleResolver resolver, JSModuleLoader loader);
+///// Returns the exports of the module specifier refers to at the top level
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="RequireJSModule")]
+/// public static extern JSValue Require(JSContext context, JSString specifier, out JSScriptException error);
+DllPublic JSValue* CDecl RequireJSModule(JSContext* context, JSString* specifier, JSScriptException** outError);
+///// Returns the compiled script of the module at fileName, e.g. to save its
+///// code cache for the next run, or null if it hasn't been loaded. The
+///// script's code is the module wrapped in a function.
+/// [DllImport("V8Simple.dll", CallingConvention = CallingConvention.Cdecl, EntryPoint="CopyJSModuleScript")]
+/// public static extern JSScript CopyScript(JSContext context, JSString fileName);
+DllPublic JSScript* CDecl CopyJSModuleScript(JSContext* context, JSString* fileName);
+/// }
+
 /// }
@@ -0,0 +1,227 @@
+// The managed counterpart of Suite.cpp, measuring the same paths through
+// the P/Invoke layer. `make bench-net` runs all of them; run
+// `dotnet bench/Bench.dll --filter '*Callback*'` afterwards for a subset.
+//
+// Results are written to BenchmarkDotNet.Artifacts/results, including JSON
+// for comparing runs over time.
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using BenchmarkDotNet.Attributes;
+using BenchmarkDotNet.Running;
+using Fuse.Scripting.V8.Simple;
+
+[MemoryDiagnoser]
+[JsonExporterAttribute.Full]
+public class Benchmarks
+{
+	JSContext _context;
+	JSFunction _noop0, _noop1, _noop4;
+	JSFunction _loop0, _loop1, _loop4;
+	JSFunction _callback, _fastCallback;
+	JSObject _obj;
+	JSString _x, _s;
+	JSArray _array;
+	JSValue[] _arrayValues;
+	JSObject _arrayBuffer;
+	readonly JSValue[] _args1 = { Value.CreateInt(1) };
+	readonly JSValue[] _args4 = { Value.CreateInt(1), Value.CreateInt(2), Value.CreateInt(3), Value.CreateInt(4) };
+	JSValue[] _callbackArgs, _fastCallbackArgs;
+	readonly Dictionary<int, string> _strings = new Dictionary<int, string>
+	{
+		{ 16, new string('a', 16) },
+		{ 1024, new string('a', 1024) },
+		{ 65536, new string('a', 65536) },
+	};
+	readonly char[] _stringBuffer = new char[65536];
+
+	const int CallsPerLoop = 1000;
+	const int ArrayLength = 1000;
+
+	static readonly JSCallback _noopCallback = NoopCallback;
+	static readonly JSFastCallback _noopFastCallback = NoopFastCallback;
+
+	static JSValue NoopCallback(JSContext context, IntPtr data, JSValue[] args, int numArgs, out JSValue error)
+	{
+		error = default(JSValue);
+		return default(JSValue);
+	}
+
+	static JSValue NoopFastCallback(JSContext context, IntPtr data, IntPtr args, int numArgs, out JSValue error)
+	{
+		error = default(JSValue);
+		return default(JSValue);
+	}
+
+	JSString CreateString(string str)
+	{
+		JSRuntimeError err;
+		return Value.CreateString(_context, str, str.Length, out err);
+	}
+
+	JSString CreateKey(string str)
+	{
+		JSRuntimeError err;
+		return Value.CreatePropertyKey(_context, str, str.Length, out err);
+	}
+
+	JSValue Evaluate(string code)
+	{
+		var fileName = CreateString("Benchmarks");
+		var source = CreateString(code);
+		JSScriptException err;
+		var result = Context.EvaluateCreate(_context, fileName, source, out err);
+		Value.Release(_context, Value.AsValue(source));
+		Value.Release(_context, Value.AsValue(fileName));
+		if (err != default(JSScriptException))
+			throw new Exception("Evaluating " + code + " failed");
+		return result;
+	}
+
+	JSFunction EvaluateFunction(string code)
+	{
+		JSRuntimeError err;
+		return Value.AsFunction(Evaluate(code), out err);
+	}
+
+	JSFunction Loop(string args)
+	{
+		return EvaluateFunction("(function(f) { for (var i = 0; i < " + CallsPerLoop + "; ++i) f(" + args + "); })");
+	}
+
+	[GlobalSetup]
+	public void Setup()
+	{
+		_context = Context.Create(null, null);
+		Context.BeginSession(_context);
+		JSRuntimeError err;
+		JSScriptException scriptErr;
+
+		_noop0 = EvaluateFunction("(function() { return 0; })");
+		_noop1 = EvaluateFunction("(function(a0) { return 0; })");
+		_noop4 = EvaluateFunction("(function(a0, a1, a2, a3) { return 0; })");
+		_loop0 = Loop("");
+		_loop1 = Loop("i");
+		_loop4 = Loop("i, i, i, i");
+		_callback = Value.CreateCallback(_context, IntPtr.Zero, _noopCallback, out scriptErr);
+		_fastCallback = Value.CreateFastCallback(_context, IntPtr.Zero, _noopFastCallback, out scriptErr);
+		_callbackArgs = new[] { Value.AsValue(_callback) };
+		_fastCallbackArgs = new[] { Value.AsValue(_fastCallback) };
+
+		_obj = Value.AsObject(Evaluate("({ x: 1, s: 'string' })"), out err);
+		_x = CreateKey("x");
+		_s = CreateKey("s");
+
+		_array = Value.AsArray(Evaluate("(function() { var a = []; for (var i = 0; i < " + ArrayLength + "; ++i) a.push(i); return a; })()"), out err);
+		_arrayValues = new JSValue[ArrayLength];
+		_arrayBuffer = Value.CreateArrayBuffer(_context, 4096, out err);
+	}
+
+	[GlobalCleanup]
+	public void Cleanup()
+	{
+		foreach (var f in new[] { _noop0, _noop1, _noop4, _loop0, _loop1, _loop4, _callback, _fastCallback })
+			Value.Release(_context, Value.AsValue(f));
+		Value.Release(_context, Value.AsValue(_obj));
+		Value.Release(_context, Value.AsValue(_x));
+		Value.Release(_context, Value.AsValue(_s));
+		Value.Release(_context, Value.AsValue(_array));
+		Value.Release(_context, Value.AsValue(_arrayBuffer));
+		Context.EndSession(_context);
+		Context.Release(_context);
+	}
+
+	[Benchmark]
+	public void CreateContext()
+	{
+		Context.Release(Context.Create(null, null));
+	}
+
+	[Benchmark]
+	public void EvaluateScript()
+	{
+		Value.Release(_context, Evaluate("1 + 1"));
+	}
+
+	void Call(JSFunction function, JSValue[] args)
+	{
+		JSScriptException err;
+		Value.Release(_context, Value.CallCreate(_context, function, default(JSObject), args, args == null ? 0 : args.Length, out err));
+	}
+
+	[Benchmark] public void CallFunction0() { Call(_noop0, null); }
+	[Benchmark] public void CallFunction1() { Call(_noop1, _args1); }
+	[Benchmark] public void CallFunction4() { Call(_noop4, _args4); }
+
+	[Benchmark(OperationsPerInvoke = CallsPerLoop)] public void Callback0() { Call(_loop0, _callbackArgs); }
+	[Benchmark(OperationsPerInvoke = CallsPerLoop)] public void Callback1() { Call(_loop1, _callbackArgs); }
+	[Benchmark(OperationsPerInvoke = CallsPerLoop)] public void Callback4() { Call(_loop4, _callbackArgs); }
+	[Benchmark(OperationsPerInvoke = CallsPerLoop)] public void FastCallback0() { Call(_loop0, _fastCallbackArgs); }
+	[Benchmark(OperationsPerInvoke = CallsPerLoop)] public void FastCallback1() { Call(_loop1, _fastCallbackArgs); }
+	[Benchmark(OperationsPerInvoke = CallsPerLoop)] public void FastCallback4() { Call(_loop4, _fastCallbackArgs); }
+
+	[Benchmark]
+	public void CopyPropertyInt()
+	{
+		JSScriptException err;
+		Value.Release(_context, Value.CopyProperty(_context, _obj, _x, out err));
+	}
+
+	[Benchmark]
+	public void CopyPropertyString()
+	{
+		JSScriptException err;
+		Value.Release(_context, Value.CopyProperty(_context, _obj, _s, out err));
+	}
+
+	[Benchmark]
+	public void SetPropertyInt()
+	{
+		JSScriptException err;
+		Value.SetProperty(_context, _obj, _x, Value.CreateInt(1), out err);
+	}
+
+	[Benchmark]
+	[Arguments(16)]
+	[Arguments(1024)]
+	[Arguments(65536)]
+	public void StringRoundTrip(int length)
+	{
+		var str = CreateString(_strings[length]);
+		Value.Write(_context, str, _stringBuffer, length);
+		Value.Release(_context, Value.AsValue(str));
+	}
+
+	[Benchmark(OperationsPerInvoke = ArrayLength)]
+	public void ArrayIterationAtIndex()
+	{
+		JSScriptException err;
+		var length = Value.Length(_context, _array);
+		for (int i = 0; i < length; ++i)
+			Value.Release(_context, Value.CopyProperty(_context, _array, i, out err));
+	}
+
+	[Benchmark(OperationsPerInvoke = ArrayLength)]
+	public void ArrayIterationRange()
+	{
+		JSRuntimeError rerr;
+		JSScriptException err;
+		Value.CopyRange(_context, _array, 0, ArrayLength, _arrayValues, out rerr, out err);
+		foreach (var value in _arrayValues)
+			Value.Release(_context, value);
+	}
+
+	[Benchmark]
+	public void ArrayBufferAccess()
+	{
+		JSRuntimeError err;
+		var data = Value.GetArrayBufferData(_context, _arrayBuffer, out err);
+		var length = Value.GetArrayBufferByteLength(_context, _arrayBuffer, out err);
+		Marshal.WriteByte(data, length - 1, 1);
+	}
+
+	public static void Main(string[] args)
+	{
+		BenchmarkSwitcher.FromTypes(new[] { typeof(Benchmarks) }).Run(args);
+	}
+}
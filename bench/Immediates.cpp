@@ -0,0 +1,119 @@
+// Counts heap allocations and time per operation for values crossing the
+// V8.Simple boundary. Run with `make bench`.
+//
+// V8Simple.o is linked statically into this program, so the operator new
+// below sees the allocations made by V8.Simple itself.
+#include "../V8Simple.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+static std::atomic<long> _allocations(0);
+
+void* operator new(size_t size)
+{
+	++_allocations;
+	if (void* p = malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+template<typename F>
+static void Measure(const char* name, int iterations, F f)
+{
+	auto allocationsBefore = _allocations.load();
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+		f(i);
+	auto end = std::chrono::steady_clock::now();
+	auto allocations = _allocations.load() - allocationsBefore;
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	printf("%-24s %8.2f allocations/op %10.1f ns/op\n",
+		name,
+		static_cast<double>(allocations) / iterations,
+		static_cast<double>(ns) / iterations);
+}
+
+static JSString* CreateString(JSContext* context, const char* str)
+{
+	std::vector<uint16_t> buffer;
+	for (; *str != 0; ++str)
+		buffer.push_back(static_cast<uint16_t>(*str));
+	JSRuntimeError error;
+	return CreateJSString(context, buffer.data(), static_cast<int>(buffer.size()), &error);
+}
+
+static JSFunction* EvaluateFunction(JSContext* context, const char* code)
+{
+	auto fileName = CreateString(context, "Immediates");
+	auto source = CreateString(context, code);
+	JSScriptException* scriptError;
+	auto value = JSContextEvaluateCreate(context, fileName, source, &scriptError);
+	ReleaseJSValue(context, JSStringAsValue(source));
+	ReleaseJSValue(context, JSStringAsValue(fileName));
+	JSRuntimeError error;
+	return JSValueAsFunction(value, &error);
+}
+
+int main()
+{
+	const int iterations = 1000000;
+	auto context = CreateJSContext(nullptr, nullptr);
+	JSRuntimeError error;
+
+	Measure("CreateJSInt", iterations, [&] (int i)
+	{
+		auto value = CreateJSInt(i);
+		JSValueAsInt(value, &error);
+		ReleaseJSValue(context, value);
+	});
+
+	Measure("CreateJSDouble", iterations, [&] (int i)
+	{
+		auto value = CreateJSDouble(i + 0.5);
+		JSValueAsDouble(value, &error);
+		ReleaseJSValue(context, value);
+	});
+
+	Measure("CreateJSBool", iterations, [&] (int i)
+	{
+		auto value = CreateJSBool(i % 2 == 0);
+		JSValueAsBool(value, &error);
+		ReleaseJSValue(context, value);
+	});
+
+	auto add = EvaluateFunction(context, "(function(x, y) { return x + y; })");
+	Measure("CallJSFunction(int)", iterations / 10, [&] (int i)
+	{
+		JSValue* args[] = { CreateJSInt(i), CreateJSInt(1) };
+		JSScriptException* scriptError;
+		auto result = CallJSFunctionCreate(context, add, nullptr, args, 2, &scriptError);
+		JSValueAsInt(result, &error);
+		ReleaseJSValue(context, result);
+		ReleaseJSValue(context, args[1]);
+		ReleaseJSValue(context, args[0]);
+	});
+
+	Measure("CallJSFunction(double)", iterations / 10, [&] (int i)
+	{
+		JSValue* args[] = { CreateJSDouble(i + 0.25), CreateJSDouble(0.5) };
+		JSScriptException* scriptError;
+		auto result = CallJSFunctionCreate(context, add, nullptr, args, 2, &scriptError);
+		JSValueAsDouble(result, &error);
+		ReleaseJSValue(context, result);
+		ReleaseJSValue(context, args[1]);
+		ReleaseJSValue(context, args[0]);
+	});
+	ReleaseJSValue(context, JSFunctionAsValue(add));
+
+	ReleaseJSContext(context);
+	return 0;
+}
@@ -0,0 +1,332 @@
+// Times the marshalling and call paths of V8.Simple: context creation,
+// evaluation, calls in both directions, property access, strings, arrays
+// and array buffers. Run with `make bench`.
+//
+//   Suite [--json] [filter]
+//
+// --json prints one JSON object per benchmark, for comparing runs over
+// time; otherwise prints a table. Only benchmarks whose name contains
+// filter are run.
+//
+// Each benchmark runs a warm-up batch and then Batches timed batches. The
+// mean, median and fastest batch are reported, as ns and heap allocations
+// per operation. V8Simple.o is linked statically into this program, so the
+// operator new below sees the allocations made by V8.Simple itself.
+#include "../V8Simple.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<long> _allocations(0);
+
+void* operator new(size_t size)
+{
+	++_allocations;
+	if (void* p = malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+static const int Batches = 10;
+static bool _json = false;
+static const char* _filter = nullptr;
+
+// Runs f(i) for i in [0, iterations), where each call does opsPerIteration
+// operations
+template<typename F>
+static void Measure(const char* name, int iterations, int opsPerIteration, F f)
+{
+	if (_filter != nullptr && strstr(name, _filter) == nullptr)
+		return;
+
+	auto batchIterations = std::max(1, iterations / Batches);
+	auto ops = static_cast<double>(batchIterations) * opsPerIteration;
+
+	for (int i = 0; i < batchIterations; ++i)
+		f(i);
+
+	std::vector<double> nsPerOp;
+	auto allocationsBefore = _allocations.load();
+	for (int batch = 0; batch < Batches; ++batch)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < batchIterations; ++i)
+			f(i);
+		auto end = std::chrono::steady_clock::now();
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		nsPerOp.push_back(static_cast<double>(ns) / ops);
+	}
+	auto allocations = static_cast<double>(_allocations.load() - allocationsBefore) / (ops * Batches);
+
+	double mean = 0;
+	for (auto ns: nsPerOp)
+		mean += ns;
+	mean /= Batches;
+	std::sort(nsPerOp.begin(), nsPerOp.end());
+	auto median = nsPerOp[Batches / 2];
+	auto min = nsPerOp[0];
+
+	if (_json)
+	{
+		printf("{\"name\":\"%s\",\"ops\":%.0f,\"nsPerOp\":%.2f,\"medianNsPerOp\":%.2f,\"minNsPerOp\":%.2f,\"allocationsPerOp\":%.3f}\n",
+			name, ops * Batches, mean, median, min, allocations);
+	}
+	else
+	{
+		printf("%-32s %12.1f ns/op %12.1f median %12.1f min %8.2f allocations/op\n",
+			name, mean, median, min, allocations);
+	}
+	fflush(stdout);
+}
+
+static std::vector<uint16_t> Utf16(const std::string& str)
+{
+	std::vector<uint16_t> buffer;
+	for (auto c: str)
+		buffer.push_back(static_cast<uint16_t>(c));
+	return buffer;
+}
+
+static JSString* CreateString(JSContext* context, const std::string& str)
+{
+	auto buffer = Utf16(str);
+	JSRuntimeError error;
+	return CreateJSString(context, buffer.data(), static_cast<int>(buffer.size()), &error);
+}
+
+static JSString* CreateKey(JSContext* context, const std::string& str)
+{
+	auto buffer = Utf16(str);
+	JSRuntimeError error;
+	return CreateJSPropertyKey(context, buffer.data(), static_cast<int>(buffer.size()), &error);
+}
+
+static JSValue* Evaluate(JSContext* context, const std::string& code)
+{
+	auto fileName = CreateString(context, "Suite");
+	auto source = CreateString(context, code);
+	JSScriptException* scriptError;
+	auto value = JSContextEvaluateCreate(context, fileName, source, &scriptError);
+	ReleaseJSValue(context, JSStringAsValue(source));
+	ReleaseJSValue(context, JSStringAsValue(fileName));
+	if (scriptError != nullptr)
+	{
+		fprintf(stderr, "Evaluating %s failed\n", code.c_str());
+		exit(1);
+	}
+	return value;
+}
+
+static JSFunction* EvaluateFunction(JSContext* context, const std::string& code)
+{
+	JSRuntimeError error;
+	return JSValueAsFunction(Evaluate(context, code), &error);
+}
+
+static JSValue* StdCall NoopCallback(JSContext* context, void* data, JSValue* const* args, int numArgs, JSValue** outError)
+{
+	return nullptr;
+}
+
+// "a0, a1, ..." for calls with numArgs arguments
+static std::string ArgList(int numArgs)
+{
+	std::string list;
+	for (int i = 0; i < numArgs; ++i)
+		list += (i == 0 ? "a" : ", a") + std::to_string(i);
+	return list;
+}
+
+static void CallBenchmarks(JSContext* context, int iterations)
+{
+	for (int numArgs: { 0, 1, 4 })
+	{
+		auto function = EvaluateFunction(context, "(function(" + ArgList(numArgs) + ") { return 0; })");
+		std::vector<JSValue*> args;
+		for (int i = 0; i < numArgs; ++i)
+			args.push_back(CreateJSInt(i));
+
+		auto name = "CallJSFunction/" + std::to_string(numArgs);
+		Measure(name.c_str(), iterations, 1, [&] (int i)
+		{
+			JSScriptException* scriptError;
+			ReleaseJSValue(context, CallJSFunctionCreate(context, function, nullptr, args.data(), numArgs, &scriptError));
+		});
+		ReleaseJSValue(context, JSFunctionAsValue(function));
+	}
+}
+
+static void CallbackBenchmarks(JSContext* context, int iterations)
+{
+	const int callsPerLoop = 1000;
+	for (int numArgs: { 0, 1, 4 })
+	{
+		std::string callArgs;
+		for (int i = 0; i < numArgs; ++i)
+			callArgs += i == 0 ? "i" : ", i";
+		auto loop = EvaluateFunction(context,
+			"(function(f) { for (var i = 0; i < " + std::to_string(callsPerLoop) + "; ++i) f(" + callArgs + "); })");
+
+		JSScriptException* scriptError;
+		JSFunction* callbacks[] =
+		{
+			CreateJSCallback(context, nullptr, NoopCallback, &scriptError),
+			CreateJSFastCallback(context, nullptr, NoopCallback, &scriptError),
+		};
+		const char* kinds[] = { "JSCallback", "JSFastCallback" };
+
+		for (int kind = 0; kind < 2; ++kind)
+		{
+			JSValue* args[] = { JSFunctionAsValue(callbacks[kind]) };
+			auto name = std::string(kinds[kind]) + "/" + std::to_string(numArgs);
+			Measure(name.c_str(), iterations / callsPerLoop, callsPerLoop, [&] (int i)
+			{
+				ReleaseJSValue(context, CallJSFunctionCreate(context, loop, nullptr, args, 1, &scriptError));
+			});
+			ReleaseJSValue(context, JSFunctionAsValue(callbacks[kind]));
+		}
+		ReleaseJSValue(context, JSFunctionAsValue(loop));
+	}
+}
+
+static void PropertyBenchmarks(JSContext* context, int iterations)
+{
+	JSRuntimeError error;
+	auto obj = JSValueAsObject(Evaluate(context, "({ x: 1, s: 'string', o: {} })"), &error);
+	auto x = CreateKey(context, "x");
+	auto s = CreateKey(context, "s");
+	auto o = CreateKey(context, "o");
+	JSScriptException* scriptError;
+
+	Measure("CopyJSObjectProperty/int", iterations, 1, [&] (int i)
+	{
+		ReleaseJSValue(context, CopyJSObjectProperty(context, obj, x, &scriptError));
+	});
+	Measure("CopyJSObjectProperty/string", iterations, 1, [&] (int i)
+	{
+		ReleaseJSValue(context, CopyJSObjectProperty(context, obj, s, &scriptError));
+	});
+	Measure("CopyJSObjectProperty/object", iterations, 1, [&] (int i)
+	{
+		ReleaseJSValue(context, CopyJSObjectProperty(context, obj, o, &scriptError));
+	});
+	Measure("SetJSObjectProperty/int", iterations, 1, [&] (int i)
+	{
+		SetJSObjectProperty(context, obj, x, CreateJSInt(i), &scriptError);
+	});
+
+	ReleaseJSValue(context, JSStringAsValue(o));
+	ReleaseJSValue(context, JSStringAsValue(s));
+	ReleaseJSValue(context, JSStringAsValue(x));
+	ReleaseJSValue(context, JSObjectAsValue(obj));
+}
+
+static void StringBenchmarks(JSContext* context, int iterations)
+{
+	for (int length: { 16, 1024, 65536 })
+	{
+		std::vector<uint16_t> source(length, 'a');
+		std::vector<uint16_t> target(length);
+		JSRuntimeError error;
+
+		auto name = "StringRoundTrip/" + std::to_string(length);
+		Measure(name.c_str(), std::max(100, iterations / length), 1, [&] (int i)
+		{
+			auto str = CreateJSString(context, source.data(), length, &error);
+			WriteJSStringUtf16(context, str, target.data(), length);
+			ReleaseJSValue(context, JSStringAsValue(str));
+		});
+	}
+}
+
+static void ArrayBenchmarks(JSContext* context, int iterations)
+{
+	const int length = 1000;
+	JSRuntimeError error;
+	auto arr = JSValueAsArray(Evaluate(context,
+		"(function() { var a = []; for (var i = 0; i < " + std::to_string(length) + "; ++i) a.push(i); return a; })()"),
+		&error);
+	std::vector<JSValue*> values(length);
+	JSScriptException* scriptError;
+
+	Measure("ArrayIteration/AtIndex", iterations / length, length, [&] (int i)
+	{
+		auto count = JSArrayLength(context, arr);
+		for (int j = 0; j < count; ++j)
+			ReleaseJSValue(context, CopyJSArrayPropertyAtIndex(context, arr, j, &scriptError));
+	});
+	Measure("ArrayIteration/Range", iterations / length, length, [&] (int i)
+	{
+		CopyJSArrayRange(context, arr, 0, length, values.data(), &error, &scriptError);
+		for (auto value: values)
+			ReleaseJSValue(context, value);
+	});
+	ReleaseJSValue(context, JSArrayAsValue(arr));
+}
+
+static void ArrayBufferBenchmarks(JSContext* context, int iterations)
+{
+	const int byteLength = 4096;
+	JSRuntimeError error;
+	auto buffer = CreateJSArrayBuffer(context, byteLength, &error);
+
+	Measure("ArrayBufferAccess", iterations, 1, [&] (int i)
+	{
+		auto data = static_cast<uint8_t*>(GetJSObjectArrayBufferData(context, buffer, &error));
+		auto length = GetJSObjectArrayBufferByteLength(context, buffer, &error);
+		data[i % length] = static_cast<uint8_t>(i);
+	});
+	Measure("CreateJSArrayBuffer/4096", iterations / 10, 1, [&] (int i)
+	{
+		ReleaseJSValue(context, JSObjectAsValue(CreateJSArrayBuffer(context, byteLength, &error)));
+	});
+	ReleaseJSValue(context, JSObjectAsValue(buffer));
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--json") == 0)
+			_json = true;
+		else
+			_filter = argv[i];
+	}
+
+	const int iterations = 100000;
+
+	Measure("CreateJSContext", 20, 1, [&] (int i)
+	{
+		ReleaseJSContext(CreateJSContext(nullptr, nullptr));
+	});
+
+	auto context = CreateJSContext(nullptr, nullptr);
+	BeginJSContextSession(context);
+
+	Measure("JSContextEvaluate", iterations / 10, 1, [&] (int i)
+	{
+		ReleaseJSValue(context, Evaluate(context, "1 + 1"));
+	});
+
+	CallBenchmarks(context, iterations);
+	CallbackBenchmarks(context, iterations * 10);
+	PropertyBenchmarks(context, iterations);
+	StringBenchmarks(context, iterations * 100);
+	ArrayBenchmarks(context, iterations * 10);
+	ArrayBufferBenchmarks(context, iterations);
+
+	EndJSContextSession(context);
+	ReleaseJSContext(context);
+	return 0;
+}
@@ -1,5 +1,6 @@
 #!/bin/sh
-export LDFLAGS=" -shared -install_name @rpath/libV8Simple.dylib -Ldeps/libs/osx -lv8_base -lv8_libbase -lv8_libplatform -lv8_libsampler -lv8_nosnapshot"
+export V8_LIBS=" -Ldeps/libs/osx -lv8_base -lv8_libbase -lv8_libplatform -lv8_libsampler -lv8_nosnapshot"
+export LDFLAGS=" -shared -install_name @rpath/libV8Simple.dylib $V8_LIBS"
 export CXXFLAGS=" -Oz -Ideps -arch i386 -arch x86_64 -fvisibility=hidden -fvisibility-inlines-hidden -DBUILDING_DLL"
 export OBJ_DIR="obj/osx"
 make lib/V8Simple.net.dll lib/libV8Simple.dylib
@@ -155,6 +155,194 @@ public class V8SimpleTests
 		Context.Release(context);
 	}
 
+	[Test]
+	public void Immediates()
+	{
+		var context = Context.Create(null, null);
+		var testName = "Immediates";
+		var id = AsFunction(Eval(context, testName, "(function(x) { return x; })"));
+		JSScriptException err;
+
+		foreach (var i in new int[] { 0, 1, -1, 1 << 28, -(1 << 28), int.MaxValue, int.MinValue })
+		{
+			var val = Value.CreateInt(i);
+			Assert.AreEqual(i, AsInt(val));
+			var res = Value.CallCreate(context, id, default(JSObject), new JSValue[] { val }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual(i, AsInt(res));
+			Value.Release(context, res);
+			Value.Release(context, val);
+		}
+
+		foreach (var d in new double[] { 0.5, -0.25, 123.4, 1e-30, 1e30, 1e-300, 1e300, double.Epsilon, double.NaN, double.PositiveInfinity, double.NegativeInfinity })
+		{
+			var val = Value.CreateDouble(d);
+			Assert.AreEqual(d, AsDouble(val));
+			var res = Value.CallCreate(context, id, default(JSObject), new JSValue[] { val }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual(d, AsDouble(res));
+			Value.Release(context, res);
+			Value.Release(context, val);
+		}
+
+		foreach (var b in new bool[] { true, false })
+		{
+			var val = Value.CreateBool(b);
+			Assert.AreEqual(b, AsBool(val));
+			var res = Value.CallCreate(context, id, default(JSObject), new JSValue[] { val }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual(b, AsBool(res));
+			Value.Release(context, res);
+			Value.Release(context, val);
+		}
+
+		Assert.IsTrue(Value.StrictEquals(context, Value.CreateDouble(0.5), Value.CreateDouble(0.5)));
+		Assert.IsFalse(Value.StrictEquals(context, Value.CreateDouble(double.NaN), Value.CreateDouble(double.NaN)));
+		Assert.IsFalse(Value.StrictEquals(context, Value.CreateInt(1), Value.CreateBool(true)));
+
+		Value.Release(context, Value.AsValue(id));
+		Context.Release(context);
+	}
+
+	static JSScript Compile(JSContext context, string name, string code, byte[] cache, out bool cacheRejected)
+	{
+		var jsName = AsJSString(context, name);
+		var jsCode = AsJSString(context, code);
+		JSScriptException err;
+		var result = Script.Compile(context, jsName, jsCode, cache, cache == null ? 0 : cache.Length, out cacheRejected, out err);
+		Value.Release(context, Value.AsValue(jsCode));
+		Value.Release(context, Value.AsValue(jsName));
+		CheckError(context, err);
+		return result;
+	}
+
+	static int RunInt(JSContext context, JSScript script)
+	{
+		JSScriptException err;
+		var result = Script.Run(context, script, out err);
+		CheckError(context, err);
+		return AsInt(result);
+	}
+
+	[Test]
+	public void Scripts()
+	{
+		var context = Context.Create(null, null);
+		var testName = "Scripts";
+		var code = "(function(x) { return x * 6; })(7)";
+		bool cacheRejected;
+
+		var script = Compile(context, testName, code, null, out cacheRejected);
+		Assert.IsFalse(cacheRejected);
+		var cache = Script.GetCodeCache(script);
+		Assert.Greater(cache.Length, 0);
+		Assert.AreEqual(42, RunInt(context, script));
+		Assert.AreEqual(42, RunInt(context, script));
+		Script.Release(context, script);
+
+		var otherContext = Context.Create(null, null);
+		var cachedScript = Compile(otherContext, testName, code, cache, out cacheRejected);
+		Assert.IsFalse(cacheRejected);
+		Assert.AreEqual(42, RunInt(otherContext, cachedScript));
+		Script.Release(otherContext, cachedScript);
+
+		var badCacheScript = Compile(otherContext, testName, code + ";", new byte[] { 1, 2, 3, 4 }, out cacheRejected);
+		Assert.IsTrue(cacheRejected);
+		Assert.AreEqual(42, RunInt(otherContext, badCacheScript));
+		Script.Release(otherContext, badCacheScript);
+		Context.Release(otherContext);
+
+		{
+			var jsName = AsJSString(context, testName);
+			var jsCode = AsJSString(context, "new ....");
+			JSScriptException err;
+			var errorScript = Script.Compile(context, jsName, jsCode, null, 0, out cacheRejected, out err);
+			Assert.AreEqual(default(JSScript), errorScript);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+			Value.Release(context, Value.AsValue(jsCode));
+			Value.Release(context, Value.AsValue(jsName));
+		}
+
+		Context.Release(context);
+	}
+
+	[Test]
+	public void ContextPools()
+	{
+		var testName = "ContextPools";
+		JSContextPoolStatistics stats;
+
+		var pool = ContextPool.Create(1, true, null, null);
+		var context1 = ContextPool.Acquire(pool);
+		var context2 = ContextPool.Acquire(pool);
+		Eval(context1, testName, "var leftover = 1;");
+		ContextPool.GetStatistics(pool, out stats);
+		Assert.AreEqual(0, stats.Hits);
+		Assert.AreEqual(2, stats.Misses);
+		Assert.AreEqual(2, stats.LiveIsolates);
+
+		ContextPool.ReleaseContext(pool, context1);
+		// The pool is full, so this one is disposed
+		ContextPool.ReleaseContext(pool, context2);
+		ContextPool.GetStatistics(pool, out stats);
+		Assert.AreEqual(1, stats.LiveIsolates);
+		Assert.AreEqual(1, stats.IdleIsolates);
+
+		var context3 = ContextPool.Acquire(pool);
+		var type3 = Eval(context3, testName, "typeof leftover");
+		Assert.AreEqual("undefined", AsString(context3, type3));
+		Value.Release(context3, type3);
+		ContextPool.GetStatistics(pool, out stats);
+		Assert.AreEqual(1, stats.Hits);
+		Assert.AreEqual(0, stats.IdleIsolates);
+
+		ContextPool.ReleaseContext(pool, context3);
+		ContextPool.Release(pool);
+
+		var keepingPool = ContextPool.Create(1, false, null, null);
+		var context4 = ContextPool.Acquire(keepingPool);
+		Eval(context4, testName, "var leftover = 1;");
+		ContextPool.ReleaseContext(keepingPool, context4);
+		var context5 = ContextPool.Acquire(keepingPool);
+		var type5 = Eval(context5, testName, "typeof leftover");
+		Assert.AreEqual("number", AsString(context5, type5));
+		Value.Release(context5, type5);
+		ContextPool.ReleaseContext(keepingPool, context5);
+		ContextPool.Release(keepingPool);
+
+		// Contexts may outlive their pool, as when finalized after it
+		var strayPool = ContextPool.Create(1, true, null, null);
+		var context6 = ContextPool.Acquire(strayPool);
+		ContextPool.Release(strayPool);
+		Assert.AreEqual(6, AsInt(Eval(context6, testName, "6")));
+		Context.Release(context6);
+	}
+
+	[Test]
+	public void Snapshots()
+	{
+		var testName = "Snapshots";
+		JSRuntimeError err;
+
+		var snapshot = Snapshot.Create(new string[] { "var prelude = { x: 40 };", "prelude.y = 2;" }, out err);
+		CheckError(err);
+		var data = Snapshot.GetData(snapshot);
+		Snapshot.Release(snapshot);
+		Assert.Greater(data.Length, 0);
+
+		for (int i = 0; i < 2; ++i)
+		{
+			var context = Context.CreateFromSnapshot(null, null, data, data.Length);
+			Assert.AreEqual(42, AsInt(Eval(context, testName, "prelude.x + prelude.y")));
+			Context.Release(context);
+		}
+
+		var failed = Snapshot.Create(new string[] { "throw 'Hello'" }, out err);
+		Assert.AreEqual(JSRuntimeError.ScriptError, err);
+		Assert.AreEqual(default(JSSnapshot), failed);
+	}
+
 	[Test]
 	public void Objects()
 	{
@@ -234,160 +422,1345 @@ public class V8SimpleTests
 		}
 
 
-		Value.Release(context, n);
-		Value.Release(context, Value.AsValue(xyz));
-		Value.Release(context, Value.AsValue(d));
-		Value.Release(context, Value.AsValue(c));
-		Value.Release(context, Value.AsValue(b));
-		Value.Release(context, Value.AsValue(a));
-		Value.Release(context, Value.AsValue(obj));
+		Value.Release(context, n);
+		Value.Release(context, Value.AsValue(xyz));
+		Value.Release(context, Value.AsValue(d));
+		Value.Release(context, Value.AsValue(c));
+		Value.Release(context, Value.AsValue(b));
+		Value.Release(context, Value.AsValue(a));
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+
+	[Test]
+	public void PropertyKeys()
+	{
+		var context = Context.Create(null, null);
+		JSRuntimeError rerr;
+		JSScriptException err;
+
+		var obj = AsObject(Eval(context, "PropertyKeys", "({ position: 12 })"));
+		var key = Value.CreatePropertyKey(context, "position", "position".Length, out rerr);
+		CheckError(rerr);
+		var sameKey = Value.CreatePropertyKey(context, "position", "position".Length, out rerr);
+		CheckError(rerr);
+		Assert.AreEqual(key, sameKey);
+		Assert.AreEqual("position", Value.ToString(context, key));
+		// Null-terminated keys are the same key
+		var terminatedKey = Value.CreatePropertyKey(context, "position", -1, out rerr);
+		CheckError(rerr);
+		Assert.AreEqual(key, terminatedKey);
+		Value.Release(context, Value.AsValue(terminatedKey));
+
+		var position = Value.CopyProperty(context, obj, key, out err);
+		CheckError(context, err);
+		Assert.AreEqual(12, AsInt(position));
+		Value.SetProperty(context, obj, sameKey, Value.CreateInt(13), out err);
+		CheckError(context, err);
+		Assert.IsTrue(Value.HasProperty(context, obj, key, out err));
+		CheckError(context, err);
+
+		// Keys stay cached after the caller's references are released
+		Value.Release(context, Value.AsValue(sameKey));
+		Value.Release(context, Value.AsValue(key));
+		key = Value.CreatePropertyKey(context, "position", "position".Length, out rerr);
+		CheckError(rerr);
+		position = Value.CopyProperty(context, obj, key, out err);
+		CheckError(context, err);
+		Assert.AreEqual(13, AsInt(position));
+
+		Value.Release(context, Value.AsValue(key));
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void IdentityCache()
+	{
+		var context = Context.Create(null, null);
+		var testName = "IdentityCache";
+		JSScriptException err;
+
+		var obj = AsObject(Eval(context, testName, "({ a: {}, b: [], c: function () {} })"));
+		var keys = new[] { AsJSString(context, "a"), AsJSString(context, "b"), AsJSString(context, "c") };
+		foreach (var key in keys)
+		{
+			var first = Value.CopyProperty(context, obj, key, out err);
+			CheckError(context, err);
+			var second = Value.CopyProperty(context, obj, key, out err);
+			CheckError(context, err);
+			Assert.AreNotEqual(first, second);
+			Assert.IsTrue(Value.StrictEquals(context, first, second));
+			Value.Release(context, second);
+			Value.Release(context, first);
+		}
+
+		Context.SetIdentityCacheEnabled(context, true);
+		foreach (var key in keys)
+		{
+			var first = Value.CopyProperty(context, obj, key, out err);
+			CheckError(context, err);
+			var second = Value.CopyProperty(context, obj, key, out err);
+			CheckError(context, err);
+			Assert.AreEqual(first, second);
+			Assert.IsTrue(Value.StrictEquals(context, first, second));
+			var type = Value.GetType(first);
+			Value.Release(context, second);
+			Value.Release(context, first);
+
+			// The wrapper is gone once released, so this gets a new one
+			var third = Value.CopyProperty(context, obj, key, out err);
+			CheckError(context, err);
+			Assert.AreEqual(type, Value.GetType(third));
+			Value.Release(context, third);
+		}
+		{
+			var global = Context.CopyGlobalObject(context);
+			var sameGlobal = Context.CopyGlobalObject(context);
+			Assert.AreEqual(global, sameGlobal);
+			// Constructed objects are cached too
+			var objectConstructor = AsFunction(Eval(context, testName, "Object"));
+			var constructed = Value.ConstructCreate(context, objectConstructor, new JSValue[0], 0, out err);
+			CheckError(context, err);
+			var constructedKey = AsJSString(context, "constructed");
+			Value.SetProperty(context, global, constructedKey, Value.AsValue(constructed), out err);
+			CheckError(context, err);
+			var fetched = Value.CopyProperty(context, global, constructedKey, out err);
+			CheckError(context, err);
+			Assert.AreEqual(Value.AsValue(constructed), fetched);
+			Value.Release(context, fetched);
+			Value.Release(context, Value.AsValue(constructedKey));
+			Value.Release(context, Value.AsValue(constructed));
+			Value.Release(context, Value.AsValue(objectConstructor));
+			Value.Release(context, Value.AsValue(sameGlobal));
+			Value.Release(context, Value.AsValue(global));
+		}
+		{
+			var first = Value.CopyProperty(context, obj, keys[0], out err);
+			CheckError(context, err);
+			Context.SetIdentityCacheEnabled(context, false);
+			var second = Value.CopyProperty(context, obj, keys[0], out err);
+			CheckError(context, err);
+			Assert.AreNotEqual(first, second);
+			Value.Release(context, second);
+			Value.Release(context, first);
+		}
+
+		var nan = Value.CreateDouble(double.NaN);
+		Assert.IsFalse(Value.StrictEquals(context, nan, nan));
+		Value.Release(context, nan);
+
+		foreach (var key in keys)
+			Value.Release(context, Value.AsValue(key));
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void Sessions()
+	{
+		var context = Context.Create(null, null);
+		var testName = "Sessions";
+
+		var obj = AsObject(Eval(context, testName, "({ a: 123 })"));
+		var a = AsJSString(context, "a");
+		JSScriptException err;
+
+		Context.BeginSession(context);
+		Context.BeginSession(context);
+		for (int i = 0; i < 100; ++i)
+		{
+			var aresult = Value.CopyProperty(context, obj, a, out err);
+			CheckError(context, err);
+			Assert.AreEqual(123, AsInt(aresult));
+			Value.Release(context, aresult);
+		}
+		Context.EndSession(context);
+		Assert.AreEqual(124, AsInt(Eval(context, testName, "124")));
+		Context.EndSession(context);
+		// Unbalanced ends are ignored
+		Context.EndSession(context);
+
+		{
+			var aresult = Value.CopyProperty(context, obj, a, out err);
+			CheckError(context, err);
+			Assert.AreEqual(123, AsInt(aresult));
+			Value.Release(context, aresult);
+		}
+
+		Value.Release(context, Value.AsValue(a));
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void Arrays()
+	{
+		var context = Context.Create(null, null);
+		var arr = AsArray(Eval(context, "Arrays", "[\"abc\", 123]"));
+		Assert.AreEqual(2, Value.Length(context, arr));
+		JSScriptException err;
+		var a = Value.CopyProperty(context, arr, 0, out err);
+		CheckError(context, err);
+		var b = Value.CopyProperty(context, arr, 1, out err);
+		CheckError(context, err);
+
+		Assert.AreEqual("abc", AsString(context, a));
+		Assert.AreEqual(123, AsInt(b));
+
+		Value.Release(context, b);
+		Value.Release(context, a);
+		Value.Release(context, Value.AsValue(arr));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void BulkProperties()
+	{
+		var context = Context.Create(null, null);
+		var testName = "BulkProperties";
+		JSScriptException err;
+		JSRuntimeError rerr;
+
+		var obj = AsObject(Eval(context, testName, "({ a: \"abc\", b: 123, get c() { throw new Error(\"c\"); } })"));
+		var keys = new[] { AsJSString(context, "a"), AsJSString(context, "b"), AsJSString(context, "d") };
+		var values = new JSValue[keys.Length];
+		{
+			Value.CopyProperties(context, obj, keys, values, keys.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual("abc", AsString(context, values[0]));
+			Assert.AreEqual(123, AsInt(values[1]));
+			Assert.AreEqual(default(JSValue), values[2]);
+			foreach (var value in values)
+				Value.Release(context, value);
+		}
+		{
+			var newValues = new[] { Value.CreateInt(1), Value.CreateInt(2), Value.CreateInt(3) };
+			Value.SetProperties(context, obj, keys, newValues, keys.Length, out err);
+			CheckError(context, err);
+			Value.CopyProperties(context, obj, keys, values, keys.Length, out err);
+			CheckError(context, err);
+			for (int i = 0; i < values.Length; ++i)
+			{
+				Assert.AreEqual(i + 1, AsInt(values[i]));
+				Value.Release(context, values[i]);
+				Value.Release(context, newValues[i]);
+			}
+		}
+		{
+			var c = AsJSString(context, "c");
+			var throwingKeys = new[] { keys[0], c };
+			Value.CopyProperties(context, obj, throwingKeys, values, throwingKeys.Length, out err);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+			Assert.AreEqual(default(JSValue), values[0]);
+			Assert.AreEqual(default(JSValue), values[1]);
+			Value.Release(context, Value.AsValue(c));
+		}
+
+		var arr = AsArray(Eval(context, testName, "[0, 1, 2, 3, 4]"));
+		{
+			var range = new JSValue[3];
+			Value.CopyRange(context, arr, 1, range.Length, range, out rerr, out err);
+			Assert.AreEqual(JSRuntimeError.NoError, rerr);
+			CheckError(context, err);
+			for (int i = 0; i < range.Length; ++i)
+			{
+				Assert.AreEqual(i + 1, AsInt(range[i]));
+				Value.Release(context, range[i]);
+			}
+		}
+		{
+			var range = new[] { Value.CreateInt(10), Value.CreateInt(11) };
+			Value.SetRange(context, arr, 4, range.Length, range, out rerr, out err);
+			Assert.AreEqual(JSRuntimeError.NoError, rerr);
+			CheckError(context, err);
+			Assert.AreEqual(6, Value.Length(context, arr));
+			var last = Value.CopyProperty(context, arr, 5, out err);
+			CheckError(context, err);
+			Assert.AreEqual(11, AsInt(last));
+			Value.Release(context, last);
+			foreach (var value in range)
+				Value.Release(context, value);
+		}
+		{
+			var range = new JSValue[1];
+			Value.CopyRange(context, arr, -1, range.Length, range, out rerr, out err);
+			Assert.AreEqual(JSRuntimeError.RangeError, rerr);
+			Assert.AreEqual(default(JSScriptException), err);
+			Value.CopyRange(context, arr, int.MaxValue, range.Length, range, out rerr, out err);
+			Assert.AreEqual(JSRuntimeError.RangeError, rerr);
+			Value.SetRange(context, arr, 0, -1, range, out rerr, out err);
+			Assert.AreEqual(JSRuntimeError.RangeError, rerr);
+			Assert.AreEqual(6, Value.Length(context, arr));
+		}
+
+		Value.Release(context, Value.AsValue(arr));
+		foreach (var key in keys)
+			Value.Release(context, Value.AsValue(key));
+		Value.Release(context, Value.AsValue(obj));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void Functions()
+	{
+		var context = Context.Create(null, null);
+		JSScriptException err;
+		{
+			var fun = AsFunction(Eval(context, "Functions", "(function(x, y) { return x * y; })"));
+			var args = new JSValue[] { Value.CreateInt(11), Value.CreateInt(12) };
+			var callResult = Value.CallCreate(context, fun, default(JSObject), args, args.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual(11 * 12, AsInt(callResult));
+			foreach (var arg in args)
+				Value.Release(context, arg);
+
+			Value.Release(context, callResult);
+			Value.Release(context, Value.AsValue(fun));
+		}
+		{
+			var str = AsFunction(Eval(context, "Functions", "String"));
+			var args = new JSValue[] { Value.AsValue(AsJSString(context, "abc 123")) };
+			var obj = Value.ConstructCreate(context, str, args, args.Length, out err);
+			foreach (var arg in args)
+				Value.Release(context, arg);
+			CheckError(context, err);
+
+			var indexOfString = AsJSString(context, "indexOf");
+			var indexOf = AsFunction(Value.CopyProperty(context, obj, indexOfString, out err));
+			CheckError(context, err);
+
+			var args2 = new JSValue[] { Value.AsValue(AsJSString(context, "1")) };
+			var index1 = Value.CallCreate(context, indexOf, obj, args2, args2.Length, out err);
+			CheckError(context, err);
+			Assert.AreEqual(4, AsInt(index1));
+			Value.Release(context, index1);
+
+			foreach (var arg in args2)
+				Value.Release(context, arg);
+
+			Value.Release(context, Value.AsValue(indexOf));
+			Value.Release(context, Value.AsValue(indexOfString));
+			Value.Release(context, Value.AsValue(obj));
+			Value.Release(context, Value.AsValue(str));
+		}
+		Context.Release(context);
+	}
+
+	static void FinalizeExternal(IntPtr external)
+	{
+		GCHandle.FromIntPtr(external).Free();
+	}
+
+	readonly JSExternalFinalizer _externalFinalizer = FinalizeExternal;
+
+	static JSExternal CreateExternal(JSContext context, object o)
+	{
+		return Value.CreateExternal(context, GCHandle.ToIntPtr(GCHandle.Alloc(o)));
+	}
+
+	static void FinalizeCallback(IntPtr data)
+	{
+		GCHandle.FromIntPtr(data).Free();
+	}
+
+	readonly JSCallbackFinalizer _callbackFinalizer = FinalizeCallback;
+
+	static JSValue CallCallback(JSContext context, IntPtr data, JSValue[] args, int numArgs, out JSValue error)
+	{
+		error = default(JSValue);
+		var fun = GCHandle.FromIntPtr(data).Target as Func<JSContext, JSValue[], JSValue>;
+		try
+		{
+			return fun(context, args);
+		}
+		catch (Exception e)
+		{
+			error = Value.AsValue(AsJSString(context, e.Message));
+		}
+		return default(JSValue);
+	}
+
+	readonly JSCallback _callCallback = CallCallback;
+
+	JSFunction CreateCallback(JSContext context, Func<JSContext, JSValue[], JSValue> cb)
+	{
+		JSScriptException err;
+		var result = Value.CreateCallback(context, GCHandle.ToIntPtr(GCHandle.Alloc(cb)), _callCallback, out err);
+		CheckError(context, err);
+		return result;
+	}
+
+	[Test]
+	public void Callbacks()
+	{
+		JSScriptException err;
+		var testName = "Callbacks";
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+
+		var f = AsFunction(Eval(context, testName, "(function(f) { return f(12, 13) + f(10, 20); })"));
+
+		var cb = CreateCallback(context, (cxt, args) =>
+		{
+			var x = AsInt(args[0]);
+			var y = AsInt(args[1]);
+			return Value.CreateInt(x + y + 1000);
+		});
+
+		System.GC.Collect();
+		System.GC.WaitForPendingFinalizers();
+
+		var result = Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(cb) }, 1, out err);
+		CheckError(context, err);
+
+		System.GC.Collect();
+		System.GC.WaitForPendingFinalizers();
+
+		Assert.AreEqual(12 + 13 + 1000 + 10 + 20 + 1000, AsInt(result));
+
+		Value.Release(context, result);
+		Value.Release(context, Value.AsValue(cb));
+		Value.Release(context, Value.AsValue(f));
+		System.GC.Collect();
+		System.GC.WaitForPendingFinalizers();
+		Context.Release(context);
+	}
+
+	static JSValue SumFastCallback(JSContext context, IntPtr data, IntPtr args, int numArgs, out JSValue error)
+	{
+		error = default(JSValue);
+		if (numArgs == 0)
+		{
+			error = Value.AsValue(AsJSString(context, "No arguments"));
+			return default(JSValue);
+		}
+		var sum = 0.0;
+		for (int i = 0; i < numArgs; ++i)
+		{
+			var arg = JSValue.ReadArg(args, i);
+			sum += Value.GetType(arg) == JSType.Int ? AsInt(arg) : AsDouble(arg);
+		}
+		return Value.CreateDouble(sum);
+	}
+
+	readonly JSFastCallback _sumFastCallback = SumFastCallback;
+
+	[Test]
+	public void FastCallbacks()
+	{
+		JSScriptException err;
+		var testName = "FastCallbacks";
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+
+		var cb = Value.CreateFastCallback(context, IntPtr.Zero, _sumFastCallback, out err);
+		CheckError(context, err);
+
+		var f = AsFunction(Eval(context, testName, "(function(f) { var x = 0; for (var i = 0; i < 1000; ++i) x += f(i, 0.5); return [x, f(1, 2, 3, 4, 5, 6, 7, 8, 9, 10)]; })"));
+		var result = AsArray(Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(cb) }, 1, out err));
+		CheckError(context, err);
+
+		var x = Value.CopyProperty(context, result, 0, out err);
+		CheckError(context, err);
+		Assert.AreEqual(999 * 1000 / 2 + 500, AsInt(x));
+		var y = Value.CopyProperty(context, result, 1, out err);
+		CheckError(context, err);
+		Assert.AreEqual(55, AsInt(y));
+
+		Value.CallCreate(context, cb, default(JSObject), null, 0, out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		Assert.AreEqual("No arguments", AsString(context, ScriptException.GetException(err)));
+		ScriptException.Release(context, err);
+
+		Value.Release(context, y);
+		Value.Release(context, x);
+		Value.Release(context, Value.AsValue(result));
+		Value.Release(context, Value.AsValue(f));
+		Value.Release(context, Value.AsValue(cb));
+		Context.Release(context);
+	}
+
+	class ClassNode
+	{
+		public int X;
+	}
+
+	[Test]
+	public void Classes()
+	{
+		var testName = "Classes";
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+		JSRuntimeError rerr;
+		JSScriptException err;
+
+		var name = AsJSString(context, "Node");
+		var x = AsJSString(context, "x");
+		var add = AsJSString(context, "add");
+		var cls = Class.Create(context, name);
+
+		Func<JSContext, JSValue, ClassNode> getNode = (cxt, obj) =>
+		{
+			JSRuntimeError e;
+			var data = Class.GetInstanceData(cxt, cls, AsObject(obj), out e);
+			CheckError(e);
+			return (ClassNode)GCHandle.FromIntPtr(data).Target;
+		};
+		Func<JSContext, JSValue[], JSValue> getX = (cxt, args) => Value.CreateInt(getNode(cxt, args[0]).X);
+		Func<JSContext, JSValue[], JSValue> setX = (cxt, args) =>
+		{
+			getNode(cxt, args[0]).X = AsInt(args[1]);
+			return default(JSValue);
+		};
+		Func<JSContext, JSValue[], JSValue> addX = (cxt, args) => Value.CreateInt(getNode(cxt, args[0]).X + AsInt(args[1]));
+
+		Class.AddAccessor(context, cls, x, GCHandle.ToIntPtr(GCHandle.Alloc(getX)), _callCallback, GCHandle.ToIntPtr(GCHandle.Alloc(setX)), _callCallback, out rerr);
+		CheckError(rerr);
+		Class.AddMethod(context, cls, add, GCHandle.ToIntPtr(GCHandle.Alloc(addX)), _callCallback, out rerr);
+		CheckError(rerr);
+
+		var node = new ClassNode { X = 1 };
+		var instance = Class.CreateInstance(context, cls, GCHandle.ToIntPtr(GCHandle.Alloc(node)), out err);
+		CheckError(context, err);
+
+		JSRuntimeError lateError;
+		Class.AddMethod(context, cls, add, IntPtr.Zero, _callCallback, out lateError);
+		Assert.AreEqual(JSRuntimeError.TypeError, lateError);
+
+		{
+			var f = AsFunction(Eval(context, testName, "(function(n) { var r = n.add(2); n.x = 5; return r + n.add(2) + n.x; })"));
+			var result = Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(instance) }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual(3 + 7 + 5, AsInt(result));
+			Assert.AreEqual(5, node.X);
+			Value.Release(context, result);
+			Value.Release(context, Value.AsValue(f));
+		}
+
+		foreach (var code in new[] { "(function(n) { return n.add.call({}, 1); })", "(function(n) { return new n.constructor(); })" })
+		{
+			var f = AsFunction(Eval(context, testName, code));
+			var result = Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(instance) }, 1, out err);
+			Assert.AreEqual(default(JSValue), result);
+			Assert.AreNotEqual(default(JSScriptException), err);
+			ScriptException.Release(context, err);
+			Value.Release(context, Value.AsValue(f));
+		}
+
+		{
+			var obj = AsObject(Eval(context, testName, "({})"));
+			Class.GetInstanceData(context, cls, obj, out rerr);
+			Assert.AreEqual(JSRuntimeError.TypeError, rerr);
+			Value.Release(context, Value.AsValue(obj));
+		}
+
+		Value.Release(context, Value.AsValue(instance));
+		Class.Release(context, cls);
+		Value.Release(context, Value.AsValue(add));
+		Value.Release(context, Value.AsValue(x));
+		Value.Release(context, Value.AsValue(name));
+		Context.Release(context);
+	}
+
+	static void CountGCEvents(IntPtr data, JSGCType type, double pauseMilliseconds)
+	{
+		var events = (List<double>)GCHandle.FromIntPtr(data).Target;
+		events.Add(pauseMilliseconds);
+	}
+
+	readonly JSGCEventHandler _countGCEvents = CountGCEvents;
+
+	[Test]
+	public void HeapStatistics()
+	{
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+
+		JSHeapStatistics statistics;
+		Heap.GetStatistics(context, out statistics);
+		Assert.Greater(statistics.UsedHeapSize, 0);
+		Assert.GreaterOrEqual(statistics.TotalHeapSize, statistics.UsedHeapSize);
+		Assert.GreaterOrEqual(statistics.HeapSizeLimit, statistics.TotalHeapSize);
+
+		var spaceCount = Heap.GetSpaceCount(context);
+		Assert.Greater(spaceCount, 0);
+		for (int i = 0; i < spaceCount; ++i)
+		{
+			JSHeapSpaceStatistics spaceStatistics;
+			Assert.IsTrue(Heap.GetSpaceStatistics(context, i, out spaceStatistics));
+			Assert.IsNotEmpty(Marshal.PtrToStringAnsi(spaceStatistics.Name));
+		}
+		JSHeapSpaceStatistics outOfRange;
+		Assert.IsFalse(Heap.GetSpaceStatistics(context, spaceCount, out outOfRange));
+
+		var events = new List<double>();
+		Heap.SetGCEventHandler(context, GCHandle.ToIntPtr(GCHandle.Alloc(events)), _countGCEvents);
+		Value.Release(context, Eval(context, "Heap", "var a; for (var i = 0; i < 1000000; ++i) a = { x: i }; 0"));
+		Assert.IsNotEmpty(events);
+		foreach (var pause in events)
+			Assert.GreaterOrEqual(pause, 0);
+
+		Heap.SetGCEventHandler(context, IntPtr.Zero, null);
+		var count = events.Count;
+		Value.Release(context, Eval(context, "Heap", "var a; for (var i = 0; i < 1000000; ++i) a = { x: i }; 0"));
+		Assert.AreEqual(count, events.Count);
+
+		Context.Release(context);
+	}
+
+	[Test]
+	public void MemoryNotifications()
+	{
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+
+		var baseline = Heap.AdjustExternalMemory(context, 0);
+		Assert.AreEqual(baseline + 1000, Heap.AdjustExternalMemory(context, 1000));
+		Assert.AreEqual(baseline, Heap.AdjustExternalMemory(context, -1000));
+
+		var size = 1024 * 1024;
+		var external = Value.CreateSizedExternal(context, GCHandle.ToIntPtr(GCHandle.Alloc(new object())), size);
+		Assert.AreEqual(baseline + size, Heap.AdjustExternalMemory(context, 0));
+		Value.Release(context, Value.AsValue(external));
+		Heap.NotifyLowMemory(context);
+		Assert.AreEqual(baseline, Heap.AdjustExternalMemory(context, 0));
+
+		var bytes = new byte[size];
+		var bytesHandle = GCHandle.Alloc(bytes, GCHandleType.Pinned);
+		JSRuntimeError rerr;
+		var buffer = Value.CreateSizedExternalArrayBuffer(context, bytesHandle.AddrOfPinnedObject(), size, GCHandle.ToIntPtr(bytesHandle), out rerr);
+		CheckError(rerr);
+		Assert.AreEqual(baseline + size, Heap.AdjustExternalMemory(context, 0));
+		Value.Release(context, Value.AsValue(buffer));
+		Heap.NotifyLowMemory(context);
+		Assert.AreEqual(baseline, Heap.AdjustExternalMemory(context, 0));
+		Value.CreateSizedExternalArrayBuffer(context, IntPtr.Zero, -1, IntPtr.Zero, out rerr);
+		Assert.AreEqual(JSRuntimeError.RangeError, rerr);
+
+		Heap.NotifyMemoryPressure(context, JSMemoryPressureLevel.Moderate);
+		Heap.NotifyMemoryPressure(context, JSMemoryPressureLevel.None);
+		Heap.NotifyIdle(context, 5);
+
+		Context.Release(context);
+	}
+
+	static void CheckTerminated(JSContext context, JSScriptException err)
+	{
+		Assert.AreNotEqual(default(JSScriptException), err);
+		Assert.AreEqual(JSScriptExceptionKind.Terminated, ScriptException.GetKind(err));
+		ScriptException.Release(context, err);
+	}
+
+	static bool _interrupted;
+
+	static void Interrupt(JSContext context, IntPtr data)
+	{
+		_interrupted = true;
+		Context.TerminateExecution(context);
+	}
+
+	readonly JSInterruptCallback _interrupt = Interrupt;
+
+	[Test]
+	public void Termination()
+	{
+		var testName = "Termination";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+
+		{
+			Context.SetTimeout(context, 100);
+			var result = Eval(context, testName, "while (true) {}", out err);
+			Assert.AreEqual(default(JSValue), result);
+			CheckTerminated(context, err);
+			Assert.IsFalse(Context.IsExecutionTerminating(context));
+			Assert.AreEqual(2, AsInt(Eval(context, testName, "1 + 1")));
+			Context.SetTimeout(context, 0);
+		}
+		{
+			var thread = new System.Threading.Thread(() =>
+			{
+				System.Threading.Thread.Sleep(100);
+				Context.TerminateExecution(context);
+			});
+			thread.Start();
+			Eval(context, testName, "while (true) {}", out err);
+			thread.Join();
+			CheckTerminated(context, err);
+			Assert.AreEqual(2, AsInt(Eval(context, testName, "1 + 1")));
+		}
+		{
+			_interrupted = false;
+			var thread = new System.Threading.Thread(() =>
+			{
+				System.Threading.Thread.Sleep(100);
+				Context.RequestInterrupt(context, IntPtr.Zero, _interrupt);
+			});
+			thread.Start();
+			Eval(context, testName, "while (true) {}", out err);
+			thread.Join();
+			Assert.IsTrue(_interrupted);
+			CheckTerminated(context, err);
+		}
+
+		Context.Release(context);
+	}
+
+	static void NearHeapLimit(JSContext context, IntPtr data, long usedHeapSize, long heapSizeLimit)
+	{
+		Assert.Greater(heapSizeLimit, 0);
+		Assert.Greater(usedHeapSize, 0);
+		Context.TerminateExecution(context);
+	}
+
+	readonly JSNearHeapLimitHandler _nearHeapLimit = NearHeapLimit;
+
+	[Test]
+	public void ContextOptions()
+	{
+		var testName = "ContextOptions";
+		var options = new JSContextOptions
+		{
+			MaxOldSpaceSize = 32,
+			NearHeapLimitHandler = _nearHeapLimit,
+			NearHeapLimitHandlerData = GCHandle.ToIntPtr(GCHandle.Alloc(new object())),
+		};
+		var context = Context.CreateWithOptions(_callbackFinalizer, _externalFinalizer, ref options);
+
+		JSHeapStatistics statistics;
+		Heap.GetStatistics(context, out statistics);
+		Assert.LessOrEqual(statistics.HeapSizeLimit, 64L * 1024 * 1024);
+
+		JSScriptException err;
+		var result = Eval(context, testName, "var a = []; while (true) a.push({ x: a.length }); 0", out err);
+		Assert.AreEqual(default(JSValue), result);
+		CheckTerminated(context, err);
+		Value.Release(context, Eval(context, testName, "a = null; 0"));
+		Assert.AreEqual(2, AsInt(Eval(context, testName, "1 + 1")));
+
+		Context.Release(context);
+	}
+
+	[Test]
+	public void ArrayBufferAllocators()
+	{
+		var testName = "ArrayBufferAllocators";
+		var fill = "var zeroed = true; for (var i = 0; i < 100000; ++i) { var a = new Uint8Array(64); for (var j = 0; j < a.length; ++j) zeroed = zeroed && a[j] == 0; a.fill(255); } zeroed ? 1 : 0";
+		JSArrayBufferStatistics statistics;
+		{
+			var context = Context.Create(null, null);
+			Assert.AreEqual(1, AsInt(Eval(context, testName, fill)));
+			Heap.GetArrayBufferStatistics(context, out statistics);
+			Assert.GreaterOrEqual(statistics.AllocationCount, 100000);
+			Assert.AreEqual(0, statistics.PoolHitCount);
+			Assert.AreEqual(0, statistics.LargeAllocationCount);
+			Context.Release(context);
+		}
+		{
+			var options = new JSContextOptions
+			{
+				ArrayBufferAllocator = JSArrayBufferAllocatorKind.Pooled,
+				LargeArrayBufferSize = 1024,
+			};
+			var context = Context.CreateWithOptions(null, null, ref options);
+			Assert.AreEqual(1, AsInt(Eval(context, testName, fill)));
+			Value.Release(context, Eval(context, testName, "var large = new ArrayBuffer(2 * 1024 * 1024); 0"));
+			Heap.GetArrayBufferStatistics(context, out statistics);
+			Assert.Greater(statistics.PoolHitCount, 0);
+			Assert.Greater(statistics.PooledBytes, 0);
+			Assert.AreEqual(1, statistics.LargeAllocationCount);
+			Assert.GreaterOrEqual(statistics.AllocatedBytes, 2 * 1024 * 1024);
+
+			Value.Release(context, Eval(context, testName, "large = null; 0"));
+			Heap.NotifyLowMemory(context);
+			Heap.GetArrayBufferStatistics(context, out statistics);
+			Assert.AreEqual(0, statistics.PooledBytes);
+			Assert.Less(statistics.AllocatedBytes, 2 * 1024 * 1024);
+			Context.Release(context);
+		}
+	}
+
+	[Test]
+	public void ConcurrentContexts()
+	{
+		var testName = "ConcurrentContexts";
+		var threads = new List<System.Threading.Thread>();
+		var results = new int[Environment.ProcessorCount * 2];
+		for (int i = 0; i < results.Length; ++i)
+		{
+			var index = i;
+			var thread = new System.Threading.Thread(() =>
+			{
+				var options = new JSContextOptions { SingleThreaded = index % 2 == 0 };
+				var context = Context.CreateWithOptions(null, null, ref options);
+				results[index] = AsInt(Eval(context, testName, "var sum = 0; for (var j = 0; j < 100000; ++j) sum += j % 7; sum + " + index));
+				Context.Release(context);
+			});
+			threads.Add(thread);
+			thread.Start();
+		}
+		foreach (var thread in threads)
+			thread.Join();
+
+		var expected = 0;
+		for (int j = 0; j < 100000; ++j)
+			expected += j % 7;
+		for (int i = 0; i < results.Length; ++i)
+			Assert.AreEqual(expected + i, results[i]);
+	}
+
+	[Test]
+	public void Platform()
+	{
+		// Other tests may have initialized V8 already, but only the first call can
+		Context.InitializePlatform(2, null);
+		Assert.IsFalse(Context.InitializePlatform(2, null));
+
+		var context = Context.Create(null, null);
+		Value.Release(context, Eval(context, "Platform", "var a; for (var i = 0; i < 1000000; ++i) a = { x: i }; 0"));
+		Assert.LessOrEqual(Context.PumpMessageLoop(context, 1), 1);
+		Assert.GreaterOrEqual(Context.PumpMessageLoop(context, 0), 0);
+		Assert.AreEqual(0, Context.PumpMessageLoop(context, 0));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void ExceptionDetails()
+	{
+		var testName = "ExceptionDetails";
+		var context = Context.Create(null, null);
+		JSScriptException err;
+
+		Eval(context, testName, "function fail() {\n\tthrow new Error('boom');\n}\nfail();", out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		Assert.AreEqual(JSScriptExceptionKind.Exception, ScriptException.GetKind(err));
+		StringAssert.Contains("boom", AsString(context, Value.AsValue(ScriptException.GetMessage(err))));
+		Assert.AreEqual(testName, AsString(context, Value.AsValue(ScriptException.GetFileName(err))));
+		Assert.AreEqual(2, ScriptException.GetLineNumber(err));
+		StringAssert.Contains("throw new Error", AsString(context, Value.AsValue(ScriptException.GetSourceLine(err))));
+		var stackTrace = ScriptException.GetStackTrace(err);
+		StringAssert.Contains("fail", AsString(context, Value.AsValue(stackTrace)));
+		Assert.AreEqual(stackTrace, ScriptException.GetStackTrace(err));
+		Assert.AreEqual(JSType.Object, Value.GetType(ScriptException.GetException(err)));
+		ScriptException.Release(context, err);
+
+		Eval(context, testName, "throw 42", out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		Assert.AreEqual(42, AsInt(ScriptException.GetException(err)));
+		Assert.AreEqual("", AsString(context, Value.AsValue(ScriptException.GetStackTrace(err))));
+		ScriptException.Release(context, err);
+
+		Eval(context, testName, "syntax error", out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		StringAssert.Contains("SyntaxError", AsString(context, Value.AsValue(ScriptException.GetMessage(err))));
+		ScriptException.Release(context, err);
+
+		Context.Release(context);
+	}
+
+	[Test]
+	public void JsonValues()
+	{
+		var context = Context.Create(null, null);
+		JSScriptException err;
+
+		var text = "{\"a\":[1,2.5,{\"b\":\"c\"}],\"d\":null,\"e\":true}";
+		var parsed = Json.Parse(context, text, text.Length, out err);
+		CheckError(context, err);
+		var a = AsArray(Value.CopyProperty(context, AsObject(parsed), AsJSString(context, "a"), out err));
+		CheckError(context, err);
+		Assert.AreEqual(1, AsInt(Value.CopyProperty(context, a, 0, out err)));
+
+		var stringified = Json.Stringify(context, parsed, 0, out err);
+		CheckError(context, err);
+		Assert.AreEqual(text, AsString(context, Value.AsValue(stringified)));
+
+		var buffer = new char[text.Length];
+		Assert.AreEqual(text.Length, Json.Stringify(context, parsed, 0, null, 0, out err));
+		Assert.AreEqual(text.Length, Json.Stringify(context, parsed, 0, buffer, buffer.Length, out err));
+		Assert.AreEqual(text, new string(buffer));
+		StringAssert.Contains("\n  \"a\"", AsString(context, Value.AsValue(Json.Stringify(context, parsed, 2, out err))));
+
+		var utf8 = System.Text.Encoding.UTF8.GetBytes("[\"\u00e9\"]");
+		var fromUtf8 = Json.ParseUtf8(context, utf8, utf8.Length, out err);
+		CheckError(context, err);
+		var utf8Buffer = new byte[16];
+		var utf8Length = Json.StringifyUtf8(context, fromUtf8, 0, utf8Buffer, utf8Buffer.Length, out err);
+		Assert.AreEqual(utf8.Length, utf8Length);
+		Array.Resize(ref utf8Buffer, utf8Length);
+		CollectionAssert.AreEqual(utf8, utf8Buffer);
+
+		Assert.AreEqual("\"x\\\"y\"", AsString(context, Value.AsValue(Json.Stringify(context, Value.AsValue(AsJSString(context, "x\"y")), 0, out err))));
+		Assert.AreEqual("42", AsString(context, Value.AsValue(Json.Stringify(context, Value.CreateInt(42), 2, out err))));
+		Assert.AreEqual("null", AsString(context, Value.AsValue(Json.Stringify(context, default(JSValue), 0, out err))));
+		// Functions can't be represented
+		var function = Eval(context, "JsonValues", "(function() {})");
+		Assert.AreEqual("", AsString(context, Value.AsValue(Json.Stringify(context, function, 0, out err))));
+		CheckError(context, err);
+		var withFunction = Eval(context, "JsonValues", "({ f: function() {} })");
+		Assert.AreEqual("{}", AsString(context, Value.AsValue(Json.Stringify(context, withFunction, 0, out err))));
+		Value.Release(context, withFunction);
+		Value.Release(context, function);
+
+		var invalid = "{a:1}";
+		Assert.AreEqual(default(JSValue), Json.Parse(context, invalid, invalid.Length, out err));
+		Assert.AreNotEqual(default(JSScriptException), err);
+		ScriptException.Release(context, err);
+
 		Context.Release(context);
 	}
 
+	[Test]
+	public void Serialization()
+	{
+		var testName = "Serialization";
+		var source = Context.Create(null, null);
+		var target = Context.Create(null, null);
+		JSScriptException err;
+
+		var value = AsObject(Eval(source, testName, "var buf = new ArrayBuffer(8); new Uint8Array(buf)[0] = 7; ({ a: [1, 2.5, 'x'], b: { c: true }, buf: buf })"));
+		var buffer = AsObject(Eval(source, testName, "buf"));
+		var serialized = Serializer.Serialize(source, Value.AsValue(value), new[] { buffer }, 1, out err);
+		CheckError(source, err);
+		Assert.AreEqual(0, AsInt(Eval(source, testName, "buf.byteLength")));
+
+		var check = AsFunction(Eval(target, testName, "(function (v) { return v.a[1] == 2.5 && v.a[2] == 'x' && v.b.c && new Uint8Array(v.buf)[0] == 7 ? 1 : 0; })"));
+		var copy = Serializer.Deserialize(target, serialized, out err);
+		CheckError(target, err);
+		var result = Value.CallCreate(target, check, default(JSObject), new[] { copy }, 1, out err);
+		CheckError(target, err);
+		Assert.AreEqual(1, AsInt(result));
+
+		// The buffer has moved to the first copy
+		Assert.AreEqual(default(JSValue), Serializer.Deserialize(target, serialized, out err));
+		Assert.AreNotEqual(default(JSScriptException), err);
+		ScriptException.Release(target, err);
+		Serializer.Release(serialized);
+
+		serialized = Serializer.Serialize(source, Eval(source, testName, "({ n: 42 })"), null, 0, out err);
+		CheckError(source, err);
+		var data = new byte[Serializer.CopyData(serialized, null, 0)];
+		Assert.AreEqual(data.Length, Serializer.CopyData(serialized, data, data.Length));
+		Serializer.Release(serialized);
+		serialized = Serializer.Create(data, data.Length);
+		var n = Value.CopyProperty(target, AsObject(Serializer.Deserialize(target, serialized, out err)), AsJSString(target, "n"), out err);
+		CheckError(target, err);
+		Assert.AreEqual(42, AsInt(n));
+		Serializer.Release(serialized);
+
+		Serializer.Serialize(source, Eval(source, testName, "(function () {})"), null, 0, out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		ScriptException.Release(source, err);
+
+		Context.Release(target);
+		Context.Release(source);
+	}
+
+	static string ProfileText(JSProfile profile)
+	{
+		var data = new byte[Profiler.CopyData(profile, null, 0)];
+		Assert.AreEqual(data.Length, Profiler.CopyData(profile, data, data.Length));
+		Profiler.Release(profile);
+		return Encoding.UTF8.GetString(data);
+	}
 
 	[Test]
-	public void Arrays()
+	public void Profiling()
 	{
+		var testName = "Profiling";
 		var context = Context.Create(null, null);
-		var arr = AsArray(Eval(context, "Arrays", "[\"abc\", 123]"));
-		Assert.AreEqual(2, Value.Length(context, arr));
+		var title = AsJSString(context, testName);
+
+		Profiler.StartCpuProfile(context, title, 100);
+		Value.Release(context, Eval(context, testName, "function hot() { var x = 0; for (var i = 0; i < 1000000; ++i) x += Math.sqrt(i); return x; } for (var i = 0; i < 50; ++i) hot(); 0"));
+		var profile = ProfileText(Profiler.StopCpuProfile(context, title));
+		StringAssert.Contains("\"nodes\":[", profile);
+		StringAssert.Contains("\"functionName\":\"hot\"", profile);
+		StringAssert.Contains("\"url\":\"Profiling\"", profile);
+		StringAssert.Contains("\"timeDeltas\":[", profile);
+
 		JSScriptException err;
-		var a = Value.CopyProperty(context, arr, 0, out err);
-		CheckError(context, err);
-		var b = Value.CopyProperty(context, arr, 1, out err);
+		var parsed = Json.Parse(context, profile, profile.Length, out err);
 		CheckError(context, err);
+		Value.Release(context, parsed);
 
-		Assert.AreEqual("abc", AsString(context, a));
-		Assert.AreEqual(123, AsInt(b));
+		Assert.AreEqual(default(JSProfile), Profiler.StopCpuProfile(context, title));
 
-		Value.Release(context, b);
-		Value.Release(context, a);
-		Value.Release(context, Value.AsValue(arr));
+		var snapshot = ProfileText(Profiler.TakeHeapSnapshot(context));
+		StringAssert.Contains("\"snapshot\"", snapshot);
+		StringAssert.Contains("\"strings\"", snapshot);
+
+		// A second profile's interval is ignored, and profiles still running
+		// are stopped with the context
+		var other = AsJSString(context, testName + "2");
+		Profiler.StartCpuProfile(context, title, 100);
+		Profiler.StartCpuProfile(context, other, 500);
+		Value.Release(context, Eval(context, testName, "hot()"));
+		var otherProfile = ProfileText(Profiler.StopCpuProfile(context, other));
+		StringAssert.Contains("\"nodes\":[", otherProfile);
+
+		Value.Release(context, Value.AsValue(other));
+		Value.Release(context, Value.AsValue(title));
 		Context.Release(context);
 	}
 
 	[Test]
-	public void Functions()
+	public void Instrumentation()
 	{
-		var context = Context.Create(null, null);
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+		var tracePath = System.IO.Path.GetTempFileName();
+
+		var built = Profiler.SetInstrumentationEnabled(true);
+		Profiler.ResetInstrumentationCounters();
+		Assert.IsTrue(Profiler.StartTracing(tracePath, null));
+		Assert.IsFalse(Profiler.StartTracing(tracePath, null));
+
+		var cb = CreateCallback(context, (cxt, args) => default(JSValue));
 		JSScriptException err;
+		for (int i = 0; i < 3; ++i)
 		{
-			var fun = AsFunction(Eval(context, "Functions", "(function(x, y) { return x * y; })"));
-			var args = new JSValue[] { Value.CreateInt(11), Value.CreateInt(12) };
-			var callResult = Value.CallCreate(context, fun, default(JSObject), args, args.Length, out err);
+			Value.Release(context, Value.CallCreate(context, cb, default(JSObject), null, 0, out err));
 			CheckError(context, err);
-			Assert.AreEqual(11 * 12, AsInt(callResult));
-			foreach (var arg in args)
-				Value.Release(context, arg);
+		}
 
-			Value.Release(context, callResult);
-			Value.Release(context, Value.AsValue(fun));
+		Profiler.StopTracing();
+		Profiler.SetInstrumentationEnabled(false);
+
+		JSCallCounter calls, callbacks;
+		Profiler.GetCallCounter(JSInstrumentedCall.CallFunction, out calls);
+		Profiler.GetCallCounter(JSInstrumentedCall.Callback, out callbacks);
+		JSObjectCounters objects;
+		Profiler.GetObjectCounters(out objects);
+		Assert.Greater(objects.LiveObjects, 0);
+		var trace = System.IO.File.ReadAllText(tracePath);
+		StringAssert.Contains("\"traceEvents\"", trace);
+		if (built)
+		{
+			Assert.AreEqual(3, calls.Calls);
+			Assert.AreEqual(3, callbacks.Calls);
+			Assert.GreaterOrEqual(calls.Nanoseconds, callbacks.Nanoseconds);
+			StringAssert.Contains("\"name\":\"CallJSFunctionCreate\"", trace);
 		}
+		else
 		{
-			var str = AsFunction(Eval(context, "Functions", "String"));
-			var args = new JSValue[] { Value.AsValue(AsJSString(context, "abc 123")) };
-			var obj = Value.ConstructCreate(context, str, args, args.Length, out err);
-			foreach (var arg in args)
-				Value.Release(context, arg);
-			CheckError(context, err);
-
-			var indexOfString = AsJSString(context, "indexOf");
-			var indexOf = AsFunction(Value.CopyProperty(context, obj, indexOfString, out err));
-			CheckError(context, err);
-
-			var args2 = new JSValue[] { Value.AsValue(AsJSString(context, "1")) };
-			var index1 = Value.CallCreate(context, indexOf, obj, args2, args2.Length, out err);
-			CheckError(context, err);
-			Assert.AreEqual(4, AsInt(index1));
-			Value.Release(context, index1);
-
-			foreach (var arg in args2)
-				Value.Release(context, arg);
-
-			Value.Release(context, Value.AsValue(indexOf));
-			Value.Release(context, Value.AsValue(indexOfString));
-			Value.Release(context, Value.AsValue(obj));
-			Value.Release(context, Value.AsValue(str));
+			Assert.AreEqual(0, calls.Calls);
+			Assert.AreEqual(0, objects.WrapperAllocations);
 		}
+
+		System.IO.File.Delete(tracePath);
+		Value.Release(context, Value.AsValue(cb));
 		Context.Release(context);
 	}
 
-	static void FinalizeExternal(IntPtr external)
+	static int _asyncCompletions;
+	static readonly JSAsyncCallback _asyncCompleted = (context, data, result) =>
 	{
-		GCHandle.FromIntPtr(external).Free();
-	}
-
-	readonly JSExternalFinalizer _externalFinalizer = FinalizeExternal;
+		System.Threading.Interlocked.Increment(ref _asyncCompletions);
+	};
 
-	static JSExternal CreateExternal(JSContext context, object o)
+	JSValue AwaitValue(JSContext context, JSAsyncResult result)
 	{
-		return Value.CreateExternal(context, GCHandle.ToIntPtr(GCHandle.Alloc(o)));
+		Assert.IsTrue(Async.Wait(result, -1));
+		Assert.IsTrue(Async.IsDone(result));
+		CheckError(context, Async.CopyError(result));
+		var value = Async.CopyValue(result);
+		Async.Release(context, result);
+		return value;
 	}
 
-	static void FinalizeCallback(IntPtr data)
+	[Test]
+	public void AsyncEvaluation()
 	{
-		GCHandle.FromIntPtr(data).Free();
-	}
+		var testName = "AsyncEvaluation";
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+		var fileName = AsJSString(context, testName);
+		var code = AsJSString(context, "function add(a, b) { return a + b; } add(1, 2)");
+
+		Assert.AreEqual(default(JSAsyncResult), Async.EvaluateAsync(context, fileName, code, IntPtr.Zero, null));
+		Assert.IsTrue(Async.StartExecutor(context));
+		Assert.IsFalse(Async.StartExecutor(context));
+
+		_asyncCompletions = 0;
+		var evaluated = Async.EvaluateAsync(context, fileName, code, IntPtr.Zero, _asyncCompleted);
+		Value.Release(context, Value.AsValue(code));
+		Assert.AreEqual(3, AsInt(AwaitValue(context, evaluated)));
+
+		var add = AsFunction(Eval(context, testName, "add"));
+		var results = new List<JSAsyncResult>();
+		for (int i = 0; i < 100; ++i)
+			results.Add(Async.CallAsync(context, add, default(JSObject), new JSValue[] { Value.CreateInt(i), Value.CreateInt(1) }, 2, IntPtr.Zero, _asyncCompleted));
+		for (int i = 0; i < 100; ++i)
+			Assert.AreEqual(i + 1, AsInt(AwaitValue(context, results[i])));
+		// Callbacks run after the result is in, so the last one may still be
+		// running when its result is waited for
+		Assert.IsTrue(System.Threading.SpinWait.SpinUntil(() => System.Threading.Volatile.Read(ref _asyncCompletions) == 101, 10000));
+
+		var throwing = AsJSString(context, "throw new Error('" + testName + "')");
+		var thrown = Async.EvaluateAsync(context, fileName, throwing, IntPtr.Zero, null);
+		Assert.IsTrue(Async.Wait(thrown, -1));
+		Assert.AreEqual(default(JSValue), Async.CopyValue(thrown));
+		var error = Async.CopyError(thrown);
+		Assert.AreNotEqual(default(JSScriptException), error);
+		StringAssert.Contains(testName, AsString(context, Value.AsValue(ScriptException.GetMessage(error))));
+		ScriptException.Release(context, error);
+		Async.Release(context, thrown);
+
+		Value.Release(context, Value.AsValue(throwing));
+		Value.Release(context, Value.AsValue(add));
+		Value.Release(context, Value.AsValue(fileName));
+		Context.Release(context);
 
-	readonly JSCallbackFinalizer _callbackFinalizer = FinalizeCallback;
+		// Pooled contexts are handed out again without their executor
+		var pool = ContextPool.Create(1, false, null, null);
+		var pooled = ContextPool.Acquire(pool);
+		Assert.IsTrue(Async.StartExecutor(pooled));
+		ContextPool.ReleaseContext(pool, pooled);
+		pooled = ContextPool.Acquire(pool);
+		Assert.IsTrue(Async.StartExecutor(pooled));
+		ContextPool.ReleaseContext(pool, pooled);
+		ContextPool.Release(pool);
+	}
 
-	static JSValue CallCallback(JSContext context, IntPtr data, JSValue[] args, int numArgs, out JSValue error)
+	[Test]
+	public void StackLimits()
 	{
-		error = default(JSValue);
-		var fun = GCHandle.FromIntPtr(data).Target as Func<JSContext, JSValue[], JSValue>;
-		try
-		{
-			return fun(context, args);
-		}
-		catch (Exception e)
-		{
-			error = Value.AsValue(AsJSString(context, e.Message));
-		}
-		return default(JSValue);
-	}
+		var testName = "StackLimits";
+		var options = new JSContextOptions { StackSize = 256 };
+		var context = Context.CreateWithOptions(null, null, ref options);
+		var fileName = AsJSString(context, testName);
+		var recurse = "(function f(n) { return n == 0 ? 0 : 1 + f(n - 1); })";
+		var shallow = AsJSString(context, recurse + "(100)");
+		var deep = AsJSString(context, recurse + "(1e7)");
+		JSScriptException err;
 
-	readonly JSCallback _callCallback = CallCallback;
+		Assert.AreEqual(100, AsInt(Eval(context, testName, recurse + "(100)")));
+		Eval(context, testName, recurse + "(1e7)", out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		ScriptException.Release(context, err);
 
-	JSFunction CreateCallback(JSContext context, Func<JSContext, JSValue[], JSValue> cb)
+		// The executor thread gets a limit of its own
+		Assert.IsTrue(Async.StartExecutor(context));
+		Assert.AreEqual(100, AsInt(AwaitValue(context, Async.EvaluateAsync(context, fileName, shallow, IntPtr.Zero, null))));
+		var overflowed = Async.EvaluateAsync(context, fileName, deep, IntPtr.Zero, null);
+		Assert.IsTrue(Async.Wait(overflowed, -1));
+		var error = Async.CopyError(overflowed);
+		Assert.AreNotEqual(default(JSScriptException), error);
+		ScriptException.Release(context, error);
+		Async.Release(context, overflowed);
+		Assert.AreEqual(100, AsInt(Eval(context, testName, recurse + "(100)")));
+
+		Value.Release(context, Value.AsValue(deep));
+		Value.Release(context, Value.AsValue(shallow));
+		Value.Release(context, Value.AsValue(fileName));
+		Context.Release(context);
+	}
+
+	[Test]
+	public void Promises()
 	{
+		var testName = "Promises";
+		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+		Context.SetMicrotasksPolicy(context, JSMicrotasksPolicy.Explicit);
+
 		JSScriptException err;
-		var result = Value.CreateCallback(context, GCHandle.ToIntPtr(GCHandle.Alloc(cb)), _callCallback, out err);
+		var resolver = Promise.CreateResolver(context, out err);
 		CheckError(context, err);
-		return result;
+		var promise = Promise.CopyPromise(context, resolver);
+		Assert.AreEqual(JSType.Promise, Value.GetType(Value.AsValue(promise)));
+		Assert.IsFalse(Promise.HasHandler(context, promise));
+
+		var watch = AsFunction(Eval(context, testName, "var settled = null; (function(p) { p.then(function(v) { settled = v; }, function(e) { settled = 'rejected ' + e; }); })"));
+		Value.Release(context, Value.CallCreate(context, watch, default(JSObject), new JSValue[] { Value.AsValue(promise) }, 1, out err));
+		CheckError(context, err);
+		Assert.IsTrue(Promise.HasHandler(context, promise));
+
+		Promise.Resolve(context, resolver, Value.CreateInt(42), out err);
+		CheckError(context, err);
+		Assert.AreEqual(JSType.Null, Value.GetType(Eval(context, testName, "settled")));
+		Context.RunMicrotasks(context);
+		Assert.AreEqual(42, AsInt(Eval(context, testName, "settled")));
+
+		var rejecter = Promise.CreateResolver(context, out err);
+		var rejected = Promise.CopyPromise(context, rejecter);
+		Value.Release(context, Value.CallCreate(context, watch, default(JSObject), new JSValue[] { Value.AsValue(rejected) }, 1, out err));
+		Promise.Reject(context, rejecter, Value.CreateInt(1), out err);
+		CheckError(context, err);
+		Context.RunMicrotasks(context);
+		Assert.AreEqual("rejected 1", AsString(context, Eval(context, testName, "settled")));
+
+		var microtask = AsFunction(Eval(context, testName, "(function() { settled = 'microtask'; })"));
+		Context.EnqueueMicrotask(context, microtask);
+		Assert.AreEqual("rejected 1", AsString(context, Eval(context, testName, "settled")));
+		Context.RunMicrotasks(context);
+		Assert.AreEqual("microtask", AsString(context, Eval(context, testName, "settled")));
+
+		var fromScript = Eval(context, testName, "Promise.resolve(1)");
+		Assert.AreEqual(JSType.Promise, Value.GetType(fromScript));
+		JSRuntimeError runtimeErr;
+		Assert.AreNotEqual(default(JSObject), Value.AsObject(fromScript, out runtimeErr));
+		CheckError(runtimeErr);
+
+		Value.Release(context, fromScript);
+		Value.Release(context, Value.AsValue(microtask));
+		Value.Release(context, Value.AsValue(rejected));
+		Promise.Release(context, rejecter);
+		Value.Release(context, Value.AsValue(watch));
+		Value.Release(context, Value.AsValue(promise));
+		Promise.Release(context, resolver);
+		Context.Release(context);
+
+		// Pooled contexts are handed out again with the Auto policy
+		var pool = ContextPool.Create(1, false, null, null);
+		var pooled = ContextPool.Acquire(pool);
+		Context.SetMicrotasksPolicy(pooled, JSMicrotasksPolicy.Explicit);
+		ContextPool.ReleaseContext(pool, pooled);
+		pooled = ContextPool.Acquire(pool);
+		Value.Release(pooled, Eval(pooled, testName, "var reacted = false; Promise.resolve().then(function() { reacted = true; });"));
+		Assert.IsTrue(AsBool(Eval(pooled, testName, "reacted")));
+		ContextPool.ReleaseContext(pool, pooled);
+		ContextPool.Release(pool);
 	}
 
+	static readonly Dictionary<string, string> _modules = new Dictionary<string, string>
+	{
+		{ "math", "exports.add = function(a, b) { return a + b; };" },
+		{ "main", "var math = require('math'); module.exports = math.add(1, 2) + require('math').add(0, 0) + require('cycle').value;" },
+		{ "cycle", "exports.value = 0; exports.main = require('main');" },
+		{ "broken", "throw new Error('broken ' + __filename);" },
+	};
+	static readonly List<string> _moduleLoads = new List<string>();
+
+	static readonly JSModuleResolver _resolveModule = (context, data, specifier, referrer) =>
+	{
+		var name = Value.ToString(context, specifier);
+		return _modules.ContainsKey(name) ? AsJSString(context, name) : default(JSString);
+	};
+
+	static readonly JSModuleLoader _loadModule = (JSContext context, IntPtr data, JSString fileName, out IntPtr cacheData, out int cacheLength) =>
+	{
+		cacheData = IntPtr.Zero;
+		cacheLength = 0;
+		var name = Value.ToString(context, fileName);
+		_moduleLoads.Add(name);
+		return AsJSString(context, _modules[name]);
+	};
+
 	[Test]
-	public void Callbacks()
+	public void Modules()
 	{
-		JSScriptException err;
-		var testName = "Callbacks";
 		var context = Context.Create(_callbackFinalizer, _externalFinalizer);
+		var main = AsJSString(context, "main");
+		JSScriptException err;
 
-		var f = AsFunction(Eval(context, testName, "(function(f) { return f(12, 13) + f(10, 20); })"));
+		Assert.AreEqual(default(JSValue), Module.Require(context, main, out err));
+		Assert.AreNotEqual(default(JSScriptException), err);
+		ScriptException.Release(context, err);
 
-		var cb = CreateCallback(context, (cxt, args) =>
+		_moduleLoads.Clear();
+		Module.SetLoader(context, IntPtr.Zero, _resolveModule, _loadModule);
+		var math = AsJSString(context, "math");
+		Assert.AreEqual(default(JSScript), Module.CopyScript(context, math));
+
+		Assert.AreEqual(3, AsInt(Module.Require(context, main, out err)));
+		CheckError(context, err);
+		Assert.AreEqual(3, AsInt(Module.Require(context, main, out err)));
+		CheckError(context, err);
+		CollectionAssert.AreEqual(new[] { "main", "math", "cycle" }, _moduleLoads);
+
+		var script = Module.CopyScript(context, math);
+		Assert.AreNotEqual(default(JSScript), script);
+		Script.Release(context, script);
+
+		var missing = AsJSString(context, "missing");
+		Assert.AreEqual(default(JSValue), Module.Require(context, missing, out err));
+		Assert.AreNotEqual(default(JSScriptException), err);
+		StringAssert.Contains("missing", AsString(context, Value.AsValue(ScriptException.GetMessage(err))));
+		ScriptException.Release(context, err);
+
+		var broken = AsJSString(context, "broken");
+		for (int i = 0; i < 2; ++i)
 		{
-			var x = AsInt(args[0]);
-			var y = AsInt(args[1]);
-			return Value.CreateInt(x + y + 1000);
-		});
+			Assert.AreEqual(default(JSValue), Module.Require(context, broken, out err));
+			Assert.AreNotEqual(default(JSScriptException), err);
+			StringAssert.Contains("broken broken", AsString(context, Value.AsValue(ScriptException.GetMessage(err))));
+			ScriptException.Release(context, err);
+		}
+		Assert.AreEqual(4, _moduleLoads.Count);
 
-		System.GC.Collect();
-		System.GC.WaitForPendingFinalizers();
+		Value.Release(context, Value.AsValue(broken));
+		Value.Release(context, Value.AsValue(missing));
+		Value.Release(context, Value.AsValue(math));
+		Value.Release(context, Value.AsValue(main));
+		Context.Release(context);
 
-		var result = Value.CallCreate(context, f, default(JSObject), new JSValue[] { Value.AsValue(cb) }, 1, out err);
-		CheckError(context, err);
+		// Data passed without a resolver isn't kept
+		_finalizedLoaderData = 0;
+		var unloaded = Context.Create(null, _loaderDataFinalizer);
+		Module.SetLoader(unloaded, GCHandle.ToIntPtr(GCHandle.Alloc(new object())), null, null);
+		Assert.AreEqual(1, _finalizedLoaderData);
+		Context.Release(unloaded);
+		Assert.AreEqual(1, _finalizedLoaderData);
+	}
 
-		System.GC.Collect();
-		System.GC.WaitForPendingFinalizers();
+	static int _finalizedLoaderData;
+	static readonly JSExternalFinalizer _loaderDataFinalizer = data =>
+	{
+		GCHandle.FromIntPtr(data).Free();
+		++_finalizedLoaderData;
+	};
 
-		Assert.AreEqual(12 + 13 + 1000 + 10 + 20 + 1000, AsInt(result));
+	[Test]
+	public void DeferredReleases()
+	{
+		var context = Context.Create(null, null);
+		var testName = "DeferredReleases";
+		var values = new JSValue[3];
+		for (int i = 0; i < values.Length; ++i)
+			values[i] = Eval(context, testName, "({ i: " + i + " })");
+		Value.Retain(context, values[0]);
+		JSScriptException err;
+		Eval(context, testName, "throw new Error('released elsewhere')", out err);
+		Assert.AreNotEqual(default(JSScriptException), err);
+		bool cacheRejected;
+		var script = Compile(context, testName, "0", null, out cacheRejected);
 
-		Value.Release(context, result);
-		Value.Release(context, Value.AsValue(cb));
-		Value.Release(context, Value.AsValue(f));
-		System.GC.Collect();
-		System.GC.WaitForPendingFinalizers();
+		Context.BeginSession(context);
+		// Doesn't wait for the session to end
+		var thread = new System.Threading.Thread(() =>
+		{
+			foreach (var value in values)
+				Value.Release(context, value);
+			ScriptException.Release(context, err);
+			Script.Release(context, script);
+		});
+		thread.Start();
+		Assert.IsTrue(thread.Join(10000));
+		// values[0] is still retained
+		Assert.AreEqual(4, Context.DrainReleases(context));
+		Assert.AreEqual(0, Context.DrainReleases(context));
+
+		// Drained by the next call into the context
+		var obj = Eval(context, testName, "({})");
+		thread = new System.Threading.Thread(() => Value.Release(context, obj));
+		thread.Start();
+		Assert.IsTrue(thread.Join(10000));
+		Assert.AreEqual(1, AsInt(Eval(context, testName, "1")));
+		Assert.AreEqual(0, Context.DrainReleases(context));
+
+		// Drained when the session ends
+		obj = Eval(context, testName, "({})");
+		thread = new System.Threading.Thread(() => Value.Release(context, obj));
+		thread.Start();
+		Assert.IsTrue(thread.Join(10000));
+		Context.EndSession(context);
+		Assert.AreEqual(0, Context.DrainReleases(context));
+
+		// Released right away while the context is idle
+		obj = Eval(context, testName, "({})");
+		thread = new System.Threading.Thread(() => Value.Release(context, obj));
+		thread.Start();
+		Assert.IsTrue(thread.Join(10000));
+		Assert.AreEqual(0, Context.DrainReleases(context));
+
+		Value.Release(context, values[0]);
 		Context.Release(context);
 	}
 
@@ -506,6 +1879,37 @@ public class V8SimpleTests
 		Context.Release(context);
 	}
 
+	[Test]
+	public void StringBuffers()
+	{
+		var context = Context.Create(null, null);
+
+		foreach (var str in _unicodeStrings)
+		{
+			var jsStr = AsJSString(context, str);
+
+			var small = new char[1];
+			var length = Value.Write(context, jsStr, small, small.Length);
+			Assert.AreEqual(str.Length, length);
+			var chars = new char[length];
+			Assert.AreEqual(str.Length, Value.Write(context, jsStr, chars, chars.Length));
+			Assert.AreEqual(str, new string(chars));
+
+			var expectedUtf8 = Encoding.UTF8.GetBytes(str);
+			var utf8Length = Value.WriteUtf8(context, jsStr, null, 0);
+			Assert.AreEqual(expectedUtf8.Length, utf8Length);
+			var bytes = new byte[utf8Length + 10];
+			Assert.AreEqual(expectedUtf8.Length, Value.WriteUtf8(context, jsStr, bytes, bytes.Length));
+			Assert.AreEqual(str, Encoding.UTF8.GetString(bytes, 0, expectedUtf8.Length));
+			if (utf8Length > 1)
+				Assert.AreEqual(utf8Length, Value.WriteUtf8(context, jsStr, bytes, utf8Length - 1));
+
+			Value.Release(context, Value.AsValue(jsStr));
+		}
+
+		Context.Release(context);
+	}
+
 	readonly string[] _unicodeStrings = new string[]
 	{
 		"",
@@ -543,6 +1947,55 @@ public class V8SimpleTests
 	};
 
 
+	static int _finalizedExternalStrings;
+
+	static void FinalizeExternalString(IntPtr data)
+	{
+		GCHandle.FromIntPtr(data).Free();
+		++_finalizedExternalStrings;
+	}
+
+	readonly JSExternalFinalizer _externalStringFinalizer = FinalizeExternalString;
+
+	[Test]
+	public void ExternalStrings()
+	{
+		var testName = "ExternalStrings";
+		_finalizedExternalStrings = 0;
+		var context = Context.Create(_callbackFinalizer, _externalStringFinalizer);
+		var id = AsFunction(Eval(context, testName, "(function(x) { return x + '!'; })"));
+		var str = "Hello external ç, é, õ 𐐷";
+		JSRuntimeError rerr;
+		JSScriptException err;
+
+		{
+			var chars = str.ToCharArray();
+			var handle = GCHandle.Alloc(chars, GCHandleType.Pinned);
+			var ext = Value.CreateExternalString(context, handle.AddrOfPinnedObject(), chars.Length, GCHandle.ToIntPtr(handle), out rerr);
+			CheckError(rerr);
+			Assert.AreEqual(str, Value.ToString(context, ext));
+			var res = Value.CallCreate(context, id, default(JSObject), new JSValue[] { Value.AsValue(ext) }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual(str + "!", AsString(context, res));
+			Value.Release(context, res);
+			Value.Release(context, Value.AsValue(ext));
+		}
+
+		{
+			var latin1 = "Latin-1 æøå";
+			var bytes = Encoding.GetEncoding("ISO-8859-1").GetBytes(latin1);
+			var handle = GCHandle.Alloc(bytes, GCHandleType.Pinned);
+			var ext = Value.CreateExternalOneByteString(context, handle.AddrOfPinnedObject(), bytes.Length, GCHandle.ToIntPtr(handle), out rerr);
+			CheckError(rerr);
+			Assert.AreEqual(latin1, Value.ToString(context, ext));
+			Value.Release(context, Value.AsValue(ext));
+		}
+
+		Value.Release(context, Value.AsValue(id));
+		Context.Release(context);
+		Assert.AreEqual(2, _finalizedExternalStrings);
+	}
+
 	class SomeObject
 	{
 		public string SomeField;
@@ -666,4 +2119,77 @@ public class V8SimpleTests
 
 		Context.Release(context);
 	}
+
+	[Test]
+	public void TypedArrays()
+	{
+		var testName = "TypedArrays";
+
+		var context = Context.Create(null, null);
+		JSRuntimeError rerr;
+		JSScriptException err;
+
+		{
+			Assert.AreEqual(default(JSObject), Value.CreateArrayBuffer(context, -1, out rerr));
+			Assert.AreEqual(JSRuntimeError.RangeError, rerr);
+
+			var arrayBuffer = Value.CreateArrayBuffer(context, 64, out rerr);
+			CheckError(rerr);
+			Assert.AreEqual(64, Value.GetArrayBufferByteLength(context, arrayBuffer, out rerr));
+			CheckError(rerr);
+
+			var floats = Value.CreateTypedArray(context, arrayBuffer, JSTypedArrayType.Float32, 8, 4, out rerr);
+			CheckError(rerr);
+			JSTypedArrayInfo info;
+			Value.GetTypedArrayInfo(context, floats, out info, out rerr);
+			CheckError(rerr);
+			Assert.AreEqual(JSTypedArrayType.Float32, info.Type);
+			Assert.AreEqual(4, info.Length);
+			Assert.AreEqual(8, info.ByteOffset);
+			Assert.AreEqual(16, info.ByteLength);
+			Assert.AreEqual(Value.GetArrayBufferData(context, arrayBuffer, out rerr) + 8, info.Data);
+			CheckError(rerr);
+
+			Marshal.Copy(new float[] { 1.5f, 2.5f, 3.5f, 4.5f }, 0, info.Data, 4);
+			var f = AsFunction(Eval(context, testName, "(function (x) { return x[0] + x[1] + x[2] + x[3]; })"));
+			var sum = Value.CallCreate(context, f, AsObject(Value.JSNull()), new JSValue[] { Value.AsValue(floats) }, 1, out err);
+			CheckError(context, err);
+			Assert.AreEqual(12, AsInt(sum));
+
+			Value.CreateTypedArray(context, arrayBuffer, JSTypedArrayType.Float64, 4, 1, out rerr);
+			Assert.AreEqual(JSRuntimeError.RangeError, rerr);
+			Value.CreateTypedArray(context, arrayBuffer, JSTypedArrayType.Int32, 0, 17, out rerr);
+			Assert.AreEqual(JSRuntimeError.RangeError, rerr);
+			Value.GetTypedArrayInfo(context, arrayBuffer, out info, out rerr);
+			Assert.AreEqual(JSRuntimeError.TypeError, rerr);
+
+			Value.Release(context, sum);
+			Value.Release(context, Value.AsValue(f));
+			Value.Release(context, Value.AsValue(floats));
+			Value.Release(context, Value.AsValue(arrayBuffer));
+		}
+
+		{
+			var ints = AsObject(Eval(context, testName, "new Int32Array([1, 2, 3, 4, 5]).subarray(1)"));
+			JSTypedArrayInfo info;
+			Value.GetTypedArrayInfo(context, ints, out info, out rerr);
+			CheckError(rerr);
+			Assert.AreEqual(JSTypedArrayType.Int32, info.Type);
+			Assert.AreEqual(4, info.Length);
+			Assert.AreEqual(4, info.ByteOffset);
+			var data = new int[info.Length];
+			Marshal.Copy(info.Data, data, 0, info.Length);
+			CollectionAssert.AreEqual(new[] { 2, 3, 4, 5 }, data);
+
+			var buffer = Value.CopyTypedArrayBuffer(context, ints, out rerr);
+			CheckError(rerr);
+			Assert.AreEqual(20, Value.GetArrayBufferByteLength(context, buffer, out rerr));
+			CheckError(rerr);
+
+			Value.Release(context, Value.AsValue(buffer));
+			Value.Release(context, Value.AsValue(ints));
+		}
+
+		Context.Release(context);
+	}
 }